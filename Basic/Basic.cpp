@@ -4,27 +4,201 @@
  * This file is the starter project for the BASIC interpreter.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "arena.hpp"
+#include "emitter.hpp"
 #include "exp.hpp"
+#include "keyword.hpp"
+#include "lexer.hpp"
+#include "mapping.hpp"
 #include "parser.hpp"
 #include "program.hpp"
+#include "tier.hpp"
 #include "Utils/error.hpp"
-#include "Utils/tokenScanner.hpp"
 #include "Utils/strlib.hpp"
 
 
 /* Function prototypes */
 
-void processLine(std::string line, Program &program, EvalState &state);
+void processLine(std::string line, Program &program, EvalState &state, std::ostream &diagnostics = std::cout);
+Statement *parseStatement(Lexer &scanner, int &folded, std::ostream &diagnostics);
+void bindStatement(Statement *stmt, Program &program);
+void reportSyntaxError(std::ostream &diagnostics);
+int loadProgram(const std::string &source, Program &program, std::ostream &diagnostics = std::cout);
+struct LoadChunk;
+void parseChunk(LoadChunk &chunk);
 void runProgram(Program &program, EvalState &state);
 void listProgram(Program &program);
+void reportStats(Program &program);
+int emitProgram(const std::string &source, Program &program, EvalState &state);
+
+/*
+ * Flag: treeWalk
+ * --------------
+ * RUN normally executes the compiled bytecode of the program.  With
+ * the --tree-walk option it walks the statement and expression trees
+ * instead, which is kept for differential testing of the compiler.
+ */
+
+bool treeWalk = false;
+
+/*
+ * Flag: showStats
+ * ---------------
+ * With the --stats option every RUN first reports what the optimizer
+ * did to the program on standard error, where it does not disturb
+ * the program's own output.
+ */
+
+bool showStats = false;
+
+/*
+ * Flag: useJit
+ * ------------
+ * With the --jit option RUN translates the bytecode into native
+ * machine code and executes that.  Where native code is not supported
+ * the bytecode interpreter runs the program as usual.
+ */
+
+bool useJit = false;
+
+/*
+ * Flag: tiered
+ * ------------
+ * With the --tiered option RUN starts in the tree-walking loop and
+ * moves hot loops to the bytecode (or, with --jit, native code) while
+ * the program runs; see tier.h.
+ */
+
+bool tiered = false;
+
+/*
+ * Flag: useClosures
+ * -----------------
+ * With the --closures option every expression is compiled into
+ * closures when its statement is parsed (see closure.h), and RUN walks
+ * the statements the way --tree-walk does.  This is the lightweight
+ * alternative to the bytecode for short programs.
+ */
+
+bool useClosures = false;
+
+/*
+ * Flag: useFlat
+ * -------------
+ * With the --flat option every expression is also stored in the
+ * program's flat expression pool when its statement is parsed (see
+ * flatexp.h), and RUN walks the statements evaluating the pool.
+ */
+
+bool useFlat = false;
+
+/*
+ * Flag: emitSource
+ * ----------------
+ * With the --emit-cpp option the interpreter does not read commands.
+ * It loads the program from the named file and writes the equivalent
+ * C++ program to standard output (see emitter.h).
+ */
+
+std::string emitSource;
+
+/*
+ * Flag: loadSource
+ * ----------------
+ * With the --load option the interpreter loads the program in the
+ * named file, as the LOAD command does, before it reads commands.
+ */
+
+std::string loadSource;
+
+/*
+ * Flag: loadThreads
+ * -----------------
+ * The number of threads LOAD parses a file on, one per core unless
+ * the --threads option says otherwise.
+ */
+
+int loadThreads = int(std::thread::hardware_concurrency());
+
+/*
+ * Type: LoadChunk
+ * ---------------
+ * A piece of a file being loaded, cut at line breaks, together with
+ * the lines parsed from it and the messages about those that did not
+ * parse.  Each chunk is parsed by a single thread.
+ */
+
+struct LoadChunk {
+    std::string_view text;
+    std::vector<Program::Line> lines;
+    std::ostringstream diagnostics;
+};
+
+/*
+ * Constant: CHUNKS_PER_THREAD
+ * ---------------------------
+ * The file is cut into this many chunks per thread, so a thread that
+ * gets easy lines takes over chunks from one that is slow.
+ */
+
+const int CHUNKS_PER_THREAD = 4;
+
 /* Main program */
 
-int main() {
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--tree-walk") {
+            treeWalk = true;
+        } else if (std::string(argv[i]) == "--stats") {
+            showStats = true;
+        } else if (std::string(argv[i]) == "--jit") {
+            useJit = true;
+        } else if (std::string(argv[i]) == "--tiered") {
+            tiered = true;
+        } else if (std::string(argv[i]) == "--closures") {
+            useClosures = true;
+        } else if (std::string(argv[i]) == "--flat") {
+            useFlat = true;
+        } else if (std::string(argv[i]) == "--emit-cpp" && i + 1 < argc) {
+            emitSource = argv[++i];
+        } else if (std::string(argv[i]) == "--load" && i + 1 < argc) {
+            loadSource = argv[++i];
+        } else if (std::string(argv[i]) == "--threads" && i + 1 < argc) {
+            loadThreads = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--tree-walk] [--tiered] [--closures] [--flat] [--stats] [--jit]"
+                      << " [--emit-cpp file] [--load file] [--threads n]" << std::endl;
+            return 1;
+        }
+    }
     EvalState state;
     Program program;
+    if (useJit && !program.getBytecode().setNative(true)) {
+        std::cerr << "--jit is not supported on this platform, using the interpreter" << std::endl;
+    }
+    if (!emitSource.empty()) {
+        return emitProgram(emitSource, program, state);
+    }
+    if (!loadSource.empty()) {
+        try {
+            loadProgram(loadSource, program);
+        } catch (ErrorException &ex) {
+            std::cout << ex.getMessage() << std::endl;
+        }
+    }
     //cout << "Stub implementation of BASIC" << endl;
     while (true) {
         try {
@@ -43,191 +217,127 @@ int main() {
 /*
  * Function: processLine
  * Usage: processLine(line, program, state);
- * -----------------------------------------
+ *        processLine(line, program, state, diagnostics);
+ * ------------------------------------------------------
  * Processes a single line entered by the user.  In this version of
  * implementation, the program reads a line, parses it as an expression,
  * and then prints the result.  In your implementation, you will
  * need to replace this method with one that can respond correctly
  * when the user enters a program line (which begins with a number)
  * or one of the BASIC commands, such as LIST or RUN.
+ *
+ * Everything parsed from the line is allocated in one arena.  A
+ * program line hands its arena over to the program together with the
+ * statement, after the arena has stopped being the current one, so
+ * that nothing allocated while the statement is bound can land in
+ * it.  A command's arena is freed when the command is done, and so is
+ * that of a line that fails to parse.
+ *
+ * The line is scanned by a Lexer, so its tokens are views into line
+ * and only the names and text the statements keep are copied.  An IF
+ * statement is read from the same tokens as the rest of the line (see
+ * readCondition); one that does not parse is dropped without a
+ * message, as it always has been.
+ *
+ * A line that does not parse is reported as SYNTAX ERROR on
+ * diagnostics, standard output by default, without raising an error:
+ * the parser returns its failures instead of throwing them, so a
+ * batch of bad lines costs no more than a batch of good ones.  Errors
+ * raised while a command runs are still reported through error().
  */
 
-void processLine(std::string line, Program &program, EvalState &state) {
-    TokenScanner scanner;
-    scanner.ignoreWhitespace();
-    scanner.scanNumbers();
-    scanner.setInput(line);
+void processLine(std::string line, Program &program, EvalState &state, std::ostream &diagnostics) {
+    Arena nodes;
+    Lexer scanner(line);
 
     if (scanner.hasMoreTokens()) {
-        std::string token = scanner.nextToken();
+        const Token token = scanner.next();
 
-        if (isdigit(token[0])) { // 行号开头
-            int lineNumber = stringToInteger(token);
+        if (token.kind == NUMBER_TOKEN) { // 行号开头
+            int lineNumber;
+            if (!Lexer::toInteger(token, lineNumber)) {
+                reportSyntaxError(diagnostics);
+                return;
+            }
             if (!scanner.hasMoreTokens()) { // 如果行号后面没有更多内容，表示是删除该行
                 program.removeSourceLine(lineNumber);
             } else { // 有内容
-                std::string stmtToken = scanner.nextToken(); // 辨别类型，以便根据不同类型创建 Statement 对象
-                Statement *stmt = nullptr;
-
-                if (stmtToken == "LET") {
-                    std::string var = scanner.nextToken();
-                    if (scanner.nextToken() != "=") {
-                        error("SYNTAX ERROR");
-                    }
-                    Expression *exp = parseExp(scanner);
-                    stmt = new LetStatement(var, exp);
-                } else if (stmtToken == "PRINT") {
-                    Expression *exp = parseExp(scanner);
-                    stmt = new PrintStatement(exp);
-                } else if (stmtToken == "INPUT") {
-                    if (!scanner.hasMoreTokens()) {
-                        error("SYNTAX ERROR");
-                    }
-                    const std::string var = scanner.nextToken();
-                    stmt = new InputStatement(var);
-                } else if (stmtToken == "REM") {
-                    std::string commentText = scanner.getRemainingInput(); // 获取 REM 后的所有内容
-                    stmt = new RemStatement(commentText);  // 生成 REM 语句
-                } else if (stmtToken == "GOTO") {
-                    if (!scanner.hasMoreTokens()) {
-                        error("SYNTAX ERROR");
-                    } // 缺目标行
-                    int targetLine = stringToInteger(scanner.nextToken());
-
-                    if (scanner.hasMoreTokens()) {
-                        error("SYNTAX ERROR");
-                    } // 多了不该有的
-                    stmt = new GotoStatement(targetLine);
-                } else if (stmtToken == "IF") {
-                    if (!scanner.hasMoreTokens()) {
-                        error("SYNTAX ERROR");
-                    } // 缺表达式
-                    try {
-                        std::string left;
-                        std::string op;
-                        std::string right;
-                        bool f_flag = false;
-                        bool left_flag = false;
-                        bool right_flag = false;
-                        for (char ch : line) {
-                            if (!f_flag) {
-                                if (ch == 'F') {
-                                    f_flag = true;
-                                }
-                                continue;
-                            }
-                            if (!left_flag && (ch == '=' || ch == '<' || ch == '>')) {
-                                left_flag = true;
-                                op = ch;
-                            } else if (!left_flag && ch != '=' && ch != '<' && ch != '>') {
-                                left += ch;
-                            } else if (left_flag) {
-                                right_flag = true;
-                                right += ch;
-                            }
-                        }
-                        if (!f_flag) { // 有用的东西啥也没有
-                            error("SYNTAX ERROR");
-                        }
-                        if (!left_flag) { // 没 = < > 运算符
-                            error("SYNTAX ERROR");
-                        }
-                        if (!right_flag) { // 没右边式子
-                            error("SYNTAX ERROR");
-                        }
-                        TokenScanner l;
-                        l.ignoreWhitespace();
-                        l.scanNumbers();
-                        l.setInput(left);
-                        Expression *lhs = nullptr;
-                        lhs = readE(l);
-                        TokenScanner r;
-                        r.ignoreWhitespace();
-                        r.scanNumbers();
-                        r.setInput(right);
-                        Expression *rhs = nullptr;
-                        rhs = readE(r);
-                        if (!r.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        }
-                        r.verifyToken("THEN");
-                        if (!r.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        }
-                        int targetLine = stringToInteger(r.nextToken());
-                        if (r.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        }
-                        /*Expression *lhs = nullptr;
-                        Expression *rhs = nullptr;
-                        std::string op;
-                        exp = readE(scanner);
-                        if (!scanner.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        } // 缺跳转
-                        lhs = ((CompoundExp *) exp)->getLHS();
-                        rhs = ((CompoundExp *) exp)->getRHS();
-                        op = ((CompoundExp *) exp)->getOp();
-                        scanner.verifyToken("THEN");
-                        if (!scanner.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        }
-                        int targetLine = stringToInteger(scanner.nextToken());
-                        if (scanner.hasMoreTokens()) {
-                            error("SYNTAX ERROR");
-                        }*/
-                        stmt = new IfStatement(lhs, op, rhs, targetLine);
-                    } catch (ErrorException &ex) {
-                    }
-                } else if (stmtToken == "END") {
-                    stmt = new EndStatement();
-                } else {
-                    error("SYNTAX ERROR");
+                int folded = 0; // 常量折叠删掉的结点数
+                Statement *stmt;
+                {
+                    Arena::Scope scope(nodes); // 交出 nodes 之前关掉，之后的分配不会落进它
+                    stmt = parseStatement(scanner, folded, diagnostics);
                 }
-
-                if (stmt != nullptr) { // stmt有效，存它
-                    program.addSourceLine(lineNumber, line);
-                    program.setParsedStatement(lineNumber, stmt);
+                if (stmt == nullptr) {
+                    return;
                 }
+                program.addSourceLine(lineNumber, line); // 先换掉旧行，它在池里的结点才能收回
+                program.setParsedStatement(lineNumber, stmt, folded, std::move(nodes));
+                bindStatement(stmt, program);
             }
         } else {
             // 处理命令的情况（即没有行号的命令）
+            Arena::Scope scope(nodes); // 命令用完就释放
             Statement *stmt = nullptr;
+            int folded = 0;
+            const Keyword keyword = keywordOf(token.text);
 
-            if (token == "RUN") {
+            if (keyword == RUN_KEYWORD) {
                 runProgram(program, state);
-            } else if (token == "LIST") {
+            } else if (keyword == LIST_KEYWORD) {
                 listProgram(program);
-            } else if (token == "CLEAR") {
+            } else if (keyword == CLEAR_KEYWORD) {
                 program.clear();
                 state.Clear();
-            } else if (token == "QUIT") {
+            } else if (keyword == QUIT_KEYWORD) {
                 exit(0);
-            } else if (token == "LET") {
-                const std::string var = scanner.nextToken();
-                if (var == "REM" || var == "LET" || var == "PRINT" || var == "INPUT" || var == "END" || var == "GOTO" || var == "IF" || var == "THEN" || var == "RUN" || var == "LIST" || var == "CLEAR" || var == "QUIT" || var == "HELP") {
-                    error("SYNTAX ERROR");
+            } else if (keyword == LOAD_KEYWORD) {
+                const std::string_view source = scanner.getRemainingInput();
+                if (source.size() < 2 || source.front() != '"' || source.back() != '"') { // 文件名要加引号
+                    reportSyntaxError(diagnostics);
+                    return;
+                }
+                loadProgram(std::string(source.substr(1, source.size() - 2)), program, diagnostics);
+            } else if (keyword == LET_KEYWORD) {
+                const std::string var(scanner.next().text);
+                if (isReservedName(var) || scanner.next().kind != EQUALS_TOKEN) { // 关键字不能当变量名
+                    reportSyntaxError(diagnostics);
+                    return;
+                }
+                const ParseResult result = parseExp(scanner);
+                if (!result.ok()) {
+                    reportSyntaxError(diagnostics);
+                    return;
                 }
-                if (scanner.nextToken() != "=") {
-                    error("SYNTAX ERROR");
+                stmt = new LetStatement(var, simplifyExp(result.exp, folded));
+            } else if (keyword == PRINT_KEYWORD) {
+                const ParseResult result = parseExp(scanner);
+                if (!result.ok()) {
+                    reportSyntaxError(diagnostics);
+                    return;
                 }
-                Expression *exp = parseExp(scanner);
-                stmt = new LetStatement(var, exp);
-            } else if (token == "PRINT") {
-                Expression *exp = parseExp(scanner);
-                stmt = new PrintStatement(exp);
-            } else if (token == "INPUT") {
-                std::string var = scanner.nextToken();
+                stmt = new PrintStatement(simplifyExp(result.exp, folded));
+            } else if (keyword == INPUT_KEYWORD) {
+                const std::string var(scanner.next().text);
                 if (scanner.hasMoreTokens()) {
-                    error("SYNTAX ERROR");
+                    reportSyntaxError(diagnostics);
+                    return;
                 }
                 stmt = new InputStatement(var);
             } else {
-                error("SYNTAX ERROR");
+                reportSyntaxError(diagnostics);
+                return;
             }
 
             // 立即执行命令
             if (stmt != nullptr) {
+                if (useClosures) {
+                    stmt->bindClosures();
+                }
+                const int mark = program.getExpressions().size(); // 命令的结点用完就丢
+                if (useFlat) {
+                    stmt->bindFlat(program.getExpressions());
+                }
                 bool erased = false;
                 try {
                     stmt->execute(state, program);
@@ -239,48 +349,378 @@ void processLine(std::string line, Program &program, EvalState &state) {
                 if (!erased) {
                     delete stmt; // 删除立即执行的语句，避免内存泄漏
                 }
+                program.getExpressions().truncate(mark);
             }
         }
     }
 }
 
+/*
+ * Function: parseStatement
+ * Usage: Statement *stmt = parseStatement(scanner, folded, diagnostics);
+ * ----------------------------------------------------------------------
+ * Parses the statement of a numbered line, from its keyword on, and
+ * adds to folded the number of nodes constant folding removed.  The
+ * statement is allocated in the current arena.  Returns NULL if the
+ * statement does not parse, after reporting SYNTAX ERROR on
+ * diagnostics; a malformed IF statement is dropped without a message.
+ */
+
+Statement *parseStatement(Lexer &scanner, int &folded, std::ostream &diagnostics) {
+    const Keyword keyword = keywordOf(scanner.next().text); // 辨别类型，以便根据不同类型创建 Statement 对象
+    Statement *stmt = nullptr;
+
+    if (keyword == LET_KEYWORD) {
+        const std::string var(scanner.next().text);
+        if (scanner.next().kind != EQUALS_TOKEN) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        }
+        const ParseResult result = parseExp(scanner);
+        if (!result.ok()) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        }
+        stmt = new LetStatement(var, simplifyExp(result.exp, folded));
+    } else if (keyword == PRINT_KEYWORD) {
+        const ParseResult result = parseExp(scanner);
+        if (!result.ok()) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        }
+        stmt = new PrintStatement(simplifyExp(result.exp, folded));
+    } else if (keyword == INPUT_KEYWORD) {
+        if (!scanner.hasMoreTokens()) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        }
+        const std::string var(scanner.next().text);
+        stmt = new InputStatement(var);
+    } else if (keyword == REM_KEYWORD) {
+        const std::string commentText(scanner.getRemainingInput()); // 获取 REM 后的所有内容
+        stmt = new RemStatement(commentText);  // 生成 REM 语句
+    } else if (keyword == GOTO_KEYWORD) {
+        int targetLine;
+        if (!Lexer::toInteger(scanner.next(), targetLine) || scanner.hasMoreTokens()) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        } // 缺目标行或多了不该有的
+        stmt = new GotoStatement(targetLine);
+    } else if (keyword == IF_KEYWORD) {
+        if (!scanner.hasMoreTokens()) {
+            reportSyntaxError(diagnostics);
+            return nullptr;
+        } // 缺表达式
+        TokenKind relation = END_TOKEN;
+        Expression *rhs = nullptr;
+        const ParseResult lhs = readCondition(scanner, relation, rhs);
+        int targetLine;
+        if (!lhs.ok() || keywordOf(scanner.next().text) != THEN_KEYWORD
+            || !Lexer::toInteger(scanner.next(), targetLine) || scanner.hasMoreTokens()) {
+            return nullptr; // 不合法的 IF 行一向是悄悄丢掉的
+        }
+        stmt = new IfStatement(simplifyExp(lhs.exp, folded), relation, simplifyExp(rhs, folded), targetLine);
+    } else if (keyword == END_KEYWORD) {
+        stmt = new EndStatement();
+    } else {
+        reportSyntaxError(diagnostics);
+        return nullptr;
+    }
+    return stmt;
+}
+
+/*
+ * Function: bindStatement
+ * Usage: bindStatement(stmt, program);
+ * ------------------------------------
+ * Gives a freshly parsed statement the extra forms of its expressions
+ * that --closures and --flat run from.  The statement must already be
+ * stored in the program, which keeps track of its nodes in the flat
+ * pool from then on.
+ */
+
+void bindStatement(Statement *stmt, Program &program) {
+    if (useClosures) {
+        stmt->bindClosures();
+    }
+    if (useFlat) {
+        program.bindFlat(stmt);
+    }
+}
+
+/*
+ * Function: reportSyntaxError
+ * Usage: reportSyntaxError(diagnostics);
+ * --------------------------------------
+ * Reports a line that does not parse.  Parse failures come back from
+ * the parser as a ParseResult, so this is the one place they turn
+ * into the message the user sees, and nothing is thrown on the way.
+ */
+
+void reportSyntaxError(std::ostream &diagnostics) {
+    diagnostics << "SYNTAX ERROR" << std::endl;
+}
+
+/*
+ * Function: runProgram
+ * Usage: runProgram(program, state);
+ * ----------------------------------
+ * Executes the program for RUN, from its first line until it ends or
+ * an error is raised.  The program is linked first, which also brings
+ * its bytecode up to date.  The back end is picked from the options:
+ *
+ * - With --tiered, a TierManager walks the statements and moves hot
+ *   loops to the bytecode (see tier.h).
+ * - With none of --tree-walk, --closures and --flat, the bytecode
+ *   runs the whole program, as native code under --jit.
+ * - Otherwise the statements are walked one after another, each
+ *   evaluating its expressions in the form those options gave them.
+ *
+ * With --stats the optimizer's report comes first.
+ */
 
 void runProgram(Program &program, EvalState &state) {
-    int lineNumber = program.getFirstLineNumber();
-    bool interrupt = false;
-    while (lineNumber != -1) {
-        Statement *stmt = program.getParsedStatement(lineNumber);
-        if (stmt != nullptr) {
-            program.AddTimes(lineNumber);
-            if (const auto *gotoStmt = dynamic_cast<GotoStatement*>(stmt)) { // stmt是GotoStatement类型的
-                interrupt = true;
-                lineNumber = gotoStmt->getTargetLine();
-            } else if (const auto *ifStmt = dynamic_cast<IfStatement*>(stmt)) { // stmt是IfStatement类型的
-                if (ifStmt->isConditionTrue(state)) {
-                    interrupt = false;
-                    lineNumber = ifStmt->getTargetLine();
-                } else {
-                    interrupt = true;
-                    lineNumber = program.getNextLineNumber(lineNumber);
-                }
-            } else if (dynamic_cast<EndStatement*>(stmt)) { // stmt是EndStatement类型的
-                interrupt = false;
-                lineNumber = -1;
-            } else { // 其他，正常转移
-                interrupt = false;
-                stmt->execute(state, program);
-                lineNumber = program.getNextLineNumber(lineNumber);
-            }
-        } else {
-            if (interrupt) {
-                std::cout << "LINE NUMBER ERROR" << std::endl;
-            }
+    Statement *stmt = program.link(); // 后继和跳转目标在这里一次解析好
+    if (showStats) {
+        reportStats(program);
+    }
+    if (stmt != nullptr && tiered) {
+        TierManager tiers; // 每次 RUN 重新开始，不留着 CLEAR 之后的语句
+        tiers.run(stmt, state, program);
+        if (showStats) {
+            std::cerr << "stats: hot loops entered the bytecode tier " << tiers.getPromotions() << " times" << std::endl;
+        }
+        return;
+    }
+    if (stmt != nullptr && !treeWalk && !useClosures && !useFlat) {
+        program.getBytecode().run(stmt, state);
+        return;
+    }
+    while (stmt != nullptr) {
+        stmt->AddTimes();
+        stmt = stmt->execute(state, program); // 每条语句自己给出下一条
+    }
+}
+
+/*
+ * Function: emitProgram
+ * Usage: return emitProgram(source, program, state);
+ * --------------------------------------------------
+ * Loads the file source the way its lines would be typed at the
+ * prompt, up to the first RUN, and writes the C++ translation of the
+ * program to standard output.  Only numbered lines are taken; other
+ * commands are skipped with a warning, and lines that do not parse
+ * are reported on standard error and left out, as they would be at
+ * the prompt.  Returns the exit status for main.
+ */
+
+int emitProgram(const std::string &source, Program &program, EvalState &state) {
+    std::ifstream in(source);
+    if (!in) {
+        std::cerr << source << ": cannot open file" << std::endl;
+        return 1;
+    }
+    std::string line;
+    while (getline(in, line)) {
+        const std::string text = trim(line);
+        if (text.empty()) {
+            continue;
+        }
+        if (text == "RUN") {
             break;
         }
+        if (!isdigit(text[0])) {
+            std::cerr << source << ": skipping command: " << text << std::endl;
+            continue;
+        }
+        std::ostringstream diagnostics;
+        try {
+            processLine(line, program, state, diagnostics);
+        } catch (ErrorException &ex) {
+            diagnostics << ex.getMessage() << std::endl;
+        }
+        if (!diagnostics.str().empty()) {
+            std::cerr << source << ": " << text << ": " << diagnostics.str();
+        }
+    }
+    emitCpp(program, source, std::cout);
+    return 0;
+}
+
+/*
+ * Function: loadProgram
+ * Usage: int count = loadProgram(source, program, diagnostics);
+ * -------------------------------------------------------------
+ * Replaces the program with the one in the file source, for LOAD and
+ * --load, and returns the number of lines it now has.  Every line of
+ * the file must be a numbered line, as it would be typed at the
+ * prompt, and the result is the program typing them in order would
+ * leave: a later line replaces an earlier one with the same number,
+ * and a line number alone deletes the line.  Lines that do not parse
+ * are reported on diagnostics in file order and left out.  Variables
+ * keep their values.
+ *
+ * A file of MappedFile::MAP_THRESHOLD bytes (16 MB) or more is
+ * mapped into memory rather than read (see mapping.h); a smaller one
+ * is read into a buffer once.  The program keeps the mapping or the
+ * buffer, and the source text of the loaded lines points into it
+ * instead of being copied line by line.  A mapped file must not be
+ * changed on disk while it is loaded; LIST checks isSourceIntact
+ * first and reports SOURCE FILE CHANGED if it was.
+ *
+ * Lines parse independently, so the file is cut at line breaks into
+ * chunks that loadThreads threads parse at the same time, each into
+ * arenas of its own (see parseChunk).  The chunks are then merged in
+ * file order, so the program, the flat expression pool and the
+ * order of the diagnostics are the same as those of a load on one
+ * thread.  Only the numbering of new variable slots may differ.
+ * With --stats the time the load took is reported on standard error.
+ */
+
+int loadProgram(const std::string &source, Program &program, std::ostream &diagnostics) {
+    const auto start = std::chrono::steady_clock::now();
+    auto file = std::make_unique<MappedFile>(source);
+    const std::string_view text = file->getText();
+
+    program.clear();
+    const std::size_t threads = std::max(1, loadThreads);
+    std::vector<LoadChunk> chunks(threads == 1 ? 1 : threads * CHUNKS_PER_THREAD);
+    std::size_t begin = 0;
+    for (std::size_t k = 0; k < chunks.size(); ++k) { // 按字节等分，切在换行处
+        std::size_t end = text.size() / chunks.size() * (k + 1);
+        end = k + 1 == chunks.size() ? text.size() : std::min(text.find('\n', std::max(begin, end)), text.size());
+        chunks[k].text = text.substr(begin, end - begin);
+        begin = std::min(end + 1, text.size());
+    }
+    if (threads == 1) {
+        parseChunk(chunks[0]);
+    } else {
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&chunks, &next] {
+                for (std::size_t k = next++; k < chunks.size(); k = next++) {
+                    parseChunk(chunks[k]);
+                }
+                Arena::closeSlab();
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::size_t parsed = 0;
+    for (const auto &chunk : chunks) {
+        parsed += chunk.lines.size();
+    }
+    std::vector<Program::Line> batch;
+    batch.reserve(parsed);
+    for (auto &chunk : chunks) { // 按文件顺序合并，报错也按文件顺序
+        diagnostics << chunk.diagnostics.str();
+        for (auto &line : chunk.lines) {
+            batch.push_back(std::move(line));
+        }
+    }
+    program.loadLines(std::move(batch), std::move(file));
+    for (int lineNumber = program.getFirstLineNumber(); lineNumber != -1;
+         lineNumber = program.getNextLineNumber(lineNumber)) { // 同号的行只留最后一行，留下的才绑定
+        bindStatement(program.getParsedStatement(lineNumber), program);
+    }
+    const int count = program.getLineCount();
+    if (showStats) {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "stats: loaded " << count << " lines (" << parsed << " parsed) from " << source
+                  << " on " << threads << " threads in " << elapsed.count() << " ms" << std::endl;
+    }
+    return count;
+}
+
+/*
+ * Function: parseChunk
+ * Usage: parseChunk(chunk);
+ * -------------------------
+ * Parses the lines of one piece of a file for loadProgram, each into
+ * an arena of its own, and collects them with their diagnostics in
+ * the chunk.  It touches nothing outside the chunk except the
+ * variable slots, so chunks can be parsed on different threads.
+ */
+
+void parseChunk(LoadChunk &chunk) {
+    const std::string_view text = chunk.text;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        std::size_t end = text.find('\n', begin);
+        if (end == std::string_view::npos) end = text.size();
+        const std::string_view line = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        Arena nodes;
+        Arena::Scope scope(nodes);
+        Lexer scanner(line);
+        if (!scanner.hasMoreTokens()) {
+            continue;
+        }
+        int lineNumber;
+        if (!Lexer::toInteger(scanner.next(), lineNumber)) { // 文件里只能有带行号的行
+            reportSyntaxError(chunk.diagnostics);
+            continue;
+        }
+        if (!scanner.hasMoreTokens()) {
+            chunk.lines.push_back({lineNumber, std::string_view(), nullptr, 0, Arena(), Arena()});
+            continue;
+        }
+        int folded = 0;
+        Statement *stmt = parseStatement(scanner, folded, chunk.diagnostics);
+        if (stmt == nullptr) {
+            continue;
+        }
+        chunk.lines.push_back({lineNumber, line, stmt, folded, std::move(nodes), Arena()}); // 之后不再分配结点
     }
 }
 
+/*
+ * Function: reportStats
+ * Usage: reportStats(program);
+ * ----------------------------
+ * Reports on standard error, for --stats, what the optimizer did to
+ * the linked program: the nodes removed by constant folding, the
+ * memory of the statements and of the flat pool, and how many
+ * statements each superinstruction shape of the bytecode covers.
+ */
+
+void reportStats(Program &program) {
+    std::cerr << "stats: constant folding removed " << program.getFoldedNodes()
+              << " expression nodes" << std::endl;
+    std::cerr << "stats: statements and expressions take " << program.getNodeBytes() << " bytes" << std::endl;
+    if (useFlat) {
+        std::cerr << "stats: the flat expression pool takes " << program.getExpressions().getBytes()
+                  << " bytes for " << program.getExpressions().size() << " nodes" << std::endl;
+    }
+    int hits[FUSION_COUNT] = {}; // 每种超级指令命中的语句数
+    for (int lineNumber = program.getFirstLineNumber(); lineNumber != -1;
+         lineNumber = program.getNextLineNumber(lineNumber)) {
+        hits[Bytecode::fusionOf(program.getParsedStatement(lineNumber))]++;
+    }
+    for (int shape = 0; shape < FUSION_COUNT; ++shape) {
+        std::cerr << "stats: " << Bytecode::fusionName(Fusion(shape)) << ": " << hits[shape] << std::endl;
+    }
+}
+
+/*
+ * Function: listProgram
+ * Usage: listProgram(program);
+ * ----------------------------
+ * Prints the source text of every line in line number order, for
+ * LIST.  The text of a loaded file is read from the file's mapping
+ * or buffer, so LIST raises SOURCE FILE CHANGED rather than reading
+ * a mapped file that has changed on disk.
+ */
+
 void listProgram(Program &program) {
+    if (!program.isSourceIntact()) { // 文件被改过，读映射的文本可能会 SIGBUS
+        error("SOURCE FILE CHANGED");
+    }
     int lineNumber = program.getFirstLineNumber();
     while (lineNumber != -1) {
         std::cout << program.getSourceLine(lineNumber) << std::endl;
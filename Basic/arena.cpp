@@ -0,0 +1,178 @@
+/*
+ * File: arena.cpp
+ * ---------------
+ * This file implements the Arena class declared in arena.h.
+ */
+
+#include <new>
+#include "arena.hpp"
+
+
+/*
+ * Implementation notes: slabs and chunks
+ * --------------------------------------
+ * A slab is a block from the heap that starts with a Slab header.
+ * New chunks are cut from the open slab one after the other.  A new
+ * chunk first gets all the rest of the slab, since nobody knows yet
+ * how many nodes its line will have.  The next time an arena needs
+ * memory, that chunk is cut down to what it has used (sealed) and
+ * the new chunk starts right after it.  Each slab counts its chunks;
+ * when the last one is released the slab is freed, or simply reused
+ * from the start if it is still the open one.  Releasing the chunk
+ * at the end of the slab before it was sealed hands its memory back
+ * to the slab straight away, which is what happens to the arena of a
+ * command typed in immediate mode.
+ *
+ * Block sizes and both headers are rounded up to the alignment of
+ * max_align_t, so every block is suitably aligned.
+ */
+
+struct Arena::Slab {
+    std::size_t size; // 头部之后可用的字节数
+    std::size_t used;
+    std::size_t chunks; // 还活着的块数
+    Chunk *tail; // 还能往后长的那块，没有时为 nullptr
+};
+
+static constexpr std::size_t roundUp(std::size_t size) {
+    return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+thread_local Arena *Arena::current = nullptr;
+thread_local Arena::Slab *Arena::openSlab = nullptr;
+
+Arena::Arena() : chunks(nullptr) {}
+
+Arena::~Arena() {
+    while (chunks != nullptr) {
+        Chunk *next = chunks->next;
+        release(chunks);
+        chunks = next;
+    }
+}
+
+Arena::Arena(Arena &&other) noexcept: chunks(other.chunks) {
+    other.chunks = nullptr;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        this->~Arena();
+        chunks = other.chunks;
+        other.chunks = nullptr;
+    }
+    return *this;
+}
+
+void *Arena::allocate(std::size_t size) {
+    size = roundUp(size);
+    if (chunks == nullptr || chunks->size - chunks->used < size) {
+        grow(size);
+    }
+    char *block = reinterpret_cast<char *>(chunks) + roundUp(sizeof(Chunk)) + chunks->used;
+    chunks->used += size;
+    return block;
+}
+
+std::size_t Arena::getBytes() const {
+    std::size_t bytes = 0;
+    for (const Chunk *chunk = chunks; chunk != nullptr; chunk = chunk->next) {
+        bytes += chunk->used;
+    }
+    return bytes;
+}
+
+void *Arena::allocateNode(std::size_t size) {
+    if (current == nullptr) {
+        static Arena loose; // 没有 Scope 时用，和程序同寿命
+        return loose.allocate(size);
+    }
+    return current->allocate(size);
+}
+
+void Arena::grow(std::size_t size) {
+    const std::size_t slabHeader = roundUp(sizeof(Slab));
+    const std::size_t chunkHeader = roundUp(sizeof(Chunk));
+    if (openSlab != nullptr) {
+        seal(openSlab);
+    }
+    const std::size_t need = chunkHeader + size;
+    Slab *slab = openSlab;
+    if (need > SLAB_SIZE - slabHeader) { // 太大，单独给一个 slab
+        slab = new(::operator new(slabHeader + need)) Slab{need, 0, 0, nullptr};
+    } else if (slab == nullptr || slab->size - slab->used < need) {
+        if (slab != nullptr && slab->chunks == 0) {
+            ::operator delete(slab);
+        }
+        slab = openSlab = new(::operator new(SLAB_SIZE)) Slab{SLAB_SIZE - slabHeader, 0, 0, nullptr};
+    }
+    auto *chunk = new(reinterpret_cast<char *>(slab) + slabHeader + slab->used)
+            Chunk{chunks, slab, slab->size - slab->used - chunkHeader, 0};
+    slab->used = slab->size;
+    slab->chunks++;
+    if (slab == openSlab) {
+        slab->tail = chunk;
+    }
+    chunks = chunk;
+}
+
+void Arena::release(Chunk *chunk) {
+    Slab *slab = chunk->slab;
+    if (slab->tail == chunk) { // 还没截短的最后一块，直接还给 slab
+        slab->used = offsetOf(chunk);
+        slab->tail = nullptr;
+    }
+    if (--slab->chunks == 0) {
+        if (slab == openSlab) {
+            slab->used = 0;
+        } else {
+            ::operator delete(slab);
+        }
+    }
+}
+
+void Arena::closeSlab() {
+    Slab *slab = openSlab;
+    if (slab == nullptr) {
+        return;
+    }
+    seal(slab);
+    openSlab = nullptr;
+    if (slab->chunks == 0) {
+        ::operator delete(slab);
+    }
+}
+
+/*
+ * Implementation notes: seal
+ * --------------------------
+ * Cuts the chunk at the end of the slab, if there still is one that
+ * may grow, down to what it has used.
+ */
+
+void Arena::seal(Slab *slab) {
+    Chunk *tail = slab->tail;
+    if (tail != nullptr) { // 上一块截到实际用的大小
+        tail->size = tail->used;
+        slab->used = offsetOf(tail) + roundUp(sizeof(Chunk)) + tail->used;
+        slab->tail = nullptr;
+    }
+}
+
+/*
+ * Implementation notes: offsetOf
+ * ------------------------------
+ * Returns where a chunk starts within the usable part of its slab.
+ */
+
+std::size_t Arena::offsetOf(const Chunk *chunk) {
+    return reinterpret_cast<const char *>(chunk) - reinterpret_cast<const char *>(chunk->slab) - roundUp(sizeof(Slab));
+}
+
+Arena::Scope::Scope(Arena &arena) : previous(current) {
+    current = &arena;
+}
+
+Arena::Scope::~Scope() {
+    current = previous;
+}
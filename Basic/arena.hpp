@@ -0,0 +1,182 @@
+/*
+ * File: arena.h
+ * -------------
+ * This interface exports the Arena class, the allocator that holds
+ * the expression and statement nodes of a program line.
+ */
+
+#ifndef _arena_h
+#define _arena_h
+
+#include <cstddef>
+
+/*
+ * Class: Arena
+ * ------------
+ * A bump allocator for the nodes of one program line.  The nodes
+ * parsed from a line are allocated together in the line's arena, so
+ * they sit next to each other in memory, and they are freed in bulk
+ * when the line is replaced or the program is cleared.
+ *
+ * Arenas do not go to the heap for every line.  They take their
+ * memory from large shared slabs, and a line that has been parsed
+ * gives the part of the slab it did not use back to the next line, so
+ * the lines of a program end up packed one after the other in the
+ * order they were entered.  A slab is freed once no arena uses it.
+ *
+ * Each thread has its own current arena and cuts its chunks from
+ * slabs of its own, so threads can fill arenas at the same time.  An
+ * arena filled on one thread may be moved to and freed on another,
+ * but only once the thread that filled it has stopped allocating.
+ *
+ * Expression and Statement allocate their objects from the current
+ * arena (see Scope).  Deleting a node still runs its destructor but
+ * leaves its memory in the arena, so an arena must outlive the
+ * destructor calls of the nodes it holds.
+ */
+
+class Arena {
+
+public:
+
+/*
+ * Constructor: Arena
+ * Usage: Arena arena;
+ * -------------------
+ * Creates an empty arena.  No memory is taken until the first block
+ * is requested.
+ */
+
+    Arena();
+
+/*
+ * Destructor: ~Arena
+ * Usage: usually implicit
+ * -----------------------
+ * Gives the memory of the arena back.
+ */
+
+    ~Arena();
+
+/*
+ * Arenas can be moved, which hands over their memory, but not copied.
+ * The blocks themselves do not move.
+ */
+
+    Arena(Arena &&other) noexcept;
+
+    Arena &operator=(Arena &&other) noexcept;
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+/*
+ * Method: allocate
+ * Usage: void *block = arena.allocate(size);
+ * ------------------------------------------
+ * Returns size bytes aligned for any object.
+ */
+
+    void *allocate(std::size_t size);
+
+/*
+ * Method: getBytes
+ * Usage: std::size_t used = arena.getBytes();
+ * -------------------------------------------
+ * Returns the number of bytes handed out by the arena.
+ */
+
+    std::size_t getBytes() const;
+
+/*
+ * Static method: allocateNode
+ * Usage: void *block = Arena::allocateNode(size);
+ * -----------------------------------------------
+ * Allocates size bytes from the current arena.  Outside any Scope the
+ * block comes from an arena that lives as long as the program.
+ */
+
+    static void *allocateNode(std::size_t size);
+
+/*
+ * Static method: closeSlab
+ * Usage: Arena::closeSlab();
+ * --------------------------
+ * Stops cutting chunks from the slab the calling thread is working
+ * on, and frees it if no arena uses it.  A worker thread calls this
+ * before it ends, so its last slab is not left behind.
+ */
+
+    static void closeSlab();
+
+/*
+ * Class: Arena::Scope
+ * -------------------
+ * Makes an arena the current one for as long as the Scope object
+ * lives.  Scopes nest; the previous arena becomes current again when
+ * the scope ends.
+ */
+
+    class Scope {
+
+    public:
+
+        explicit Scope(Arena &arena);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+
+        Arena *previous;
+
+    };
+
+/*
+ * Constant: SLAB_SIZE
+ * -------------------
+ * The size of the slabs arenas take their memory from.  A request
+ * too large for a slab gets a slab of its own.
+ */
+
+    static const std::size_t SLAB_SIZE = 64 * 1024;
+
+private:
+
+    struct Slab;
+
+/*
+ * Type: Chunk
+ * -----------
+ * A piece of a slab that belongs to one arena, preceded by this
+ * header.  An arena is a list of chunks, usually only one.  The chunk
+ * at the end of the open slab may still grow into the rest of the
+ * slab; it is cut down to what it uses as soon as another arena
+ * needs memory.
+ */
+
+    struct Chunk {
+        Chunk *next;
+        Slab *slab;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    Chunk *chunks; // 最新的块在前
+
+    void grow(std::size_t size);
+    static void release(Chunk *chunk);
+    static std::size_t offsetOf(const Chunk *chunk);
+
+    static void seal(Slab *slab);
+
+    static thread_local Arena *current; // 每个线程各有一个
+    static thread_local Slab *openSlab;
+
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * File: closure.cpp
+ * -----------------
+ * This file implements the Closure class declared in closure.h.
+ */
+
+#include "closure.hpp"
+#include "Utils/error.hpp"
+
+
+/*
+ * Implementation notes: operands
+ * ------------------------------
+ * The node functions are templates over the kind of each operand, so
+ * that every combination gets its own function with the operand fetch
+ * inlined.  The operand policies read the left operand from a or lhs
+ * and the right one from b or rhs.
+ */
+
+typedef Closure::Node Node;
+
+enum OperandKind {
+    CONST_OPERAND, VAR_OPERAND, NODE_OPERAND
+};
+
+static inline int loadVariable(EvalState &state, int slot) {
+    if (!state.isDefined(slot)) error("VARIABLE NOT DEFINED");
+    return state.getValue(slot);
+}
+
+struct ConstLeft {
+    static int get(const Node &node, EvalState &state) { return node.a; }
+};
+
+struct VarLeft {
+    static int get(const Node &node, EvalState &state) { return loadVariable(state, node.a); }
+};
+
+struct NodeLeft {
+    static int get(const Node &node, EvalState &state) { return node.lhs->fn(*node.lhs, state); }
+};
+
+struct ConstRight {
+    static int get(const Node &node, EvalState &state) { return node.b; }
+};
+
+struct VarRight {
+    static int get(const Node &node, EvalState &state) { return loadVariable(state, node.b); }
+};
+
+struct NodeRight {
+    static int get(const Node &node, EvalState &state) { return node.rhs->fn(*node.rhs, state); }
+};
+
+enum Operator {
+    ADD_OP, SUB_OP, MUL_OP, DIV_OP, OTHER_OP
+};
+
+/*
+ * Implementation notes: node functions
+ * ------------------------------------
+ * binary evaluates the left operand before the right one, as
+ * CompoundExp::eval does, and an operator the parser let through
+ * without a meaning still evaluates both operands and yields 0.
+ */
+
+static int constant(const Node &node, EvalState &state) {
+    return node.a;
+}
+
+static int variable(const Node &node, EvalState &state) {
+    return loadVariable(state, node.a);
+}
+
+template <Operator op, typename Left, typename Right>
+static int binary(const Node &node, EvalState &state) {
+    const int left = Left::get(node, state);
+    const int right = Right::get(node, state);
+    switch (op) {
+        case ADD_OP:
+            return left + right;
+        case SUB_OP:
+            return left - right;
+        case MUL_OP:
+            return left * right;
+        case DIV_OP:
+            if (right == 0) error("DIVIDE BY ZERO");
+            return left / right;
+        default:
+            return 0;
+    }
+}
+
+template <typename Right>
+static int assign(const Node &node, EvalState &state) {
+    const int value = Right::get(node, state);
+    state.setValue(node.a, value);
+    return value;
+}
+
+static int illegalAssignment(const Node &node, EvalState &state) {
+    error("Illegal variable in assignment");
+    return 0;
+}
+
+static int assignToLet(const Node &node, EvalState &state) {
+    error("SYNTAX ERROR");
+    return 0;
+}
+
+typedef int (*NodeFunction)(const Node &node, EvalState &state);
+
+template <Operator op>
+static NodeFunction pickBinary(OperandKind left, OperandKind right) {
+    static const NodeFunction table[3][3] = {
+            {binary<op, ConstLeft, ConstRight>, binary<op, ConstLeft, VarRight>, binary<op, ConstLeft, NodeRight>},
+            {binary<op, VarLeft, ConstRight>, binary<op, VarLeft, VarRight>, binary<op, VarLeft, NodeRight>},
+            {binary<op, NodeLeft, ConstRight>, binary<op, NodeLeft, VarRight>, binary<op, NodeLeft, NodeRight>}
+    };
+    return table[left][right];
+}
+
+static int countNodes(Expression *exp) {
+    if (exp->getType() != COMPOUND) {
+        return 1;
+    }
+    auto *compound = (CompoundExp *) exp;
+    return 1 + countNodes(compound->getLHS()) + countNodes(compound->getRHS());
+}
+
+static OperandKind kindOf(Expression *exp) {
+    switch (exp->getType()) {
+        case CONSTANT:
+            return CONST_OPERAND;
+        case IDENTIFIER:
+            return VAR_OPERAND;
+        default:
+            return NODE_OPERAND;
+    }
+}
+
+Closure::Closure(Expression *exp) {
+    nodes.reserve(countNodes(exp)); // 结点之间用指针相连，不能扩容
+    root = build(exp);
+}
+
+/*
+ * Implementation notes: build
+ * ---------------------------
+ * A constant or variable operand is stored in its parent node instead
+ * of getting a node of its own; only a whole expression that is a
+ * single constant or variable needs a node for it.
+ */
+
+const Node *Closure::build(Expression *exp) {
+    Node node = {nullptr, 0, 0, nullptr, nullptr};
+    switch (exp->getType()) {
+        case CONSTANT:
+            node.fn = constant;
+            node.a = ((ConstantExp *) exp)->getValue();
+            break;
+        case IDENTIFIER:
+            node.fn = variable;
+            node.a = ((IdentifierExp *) exp)->getSlot();
+            break;
+        case COMPOUND: {
+            auto *compound = (CompoundExp *) exp;
+            const std::string op = compound->getOp();
+            Expression *lhs = compound->getLHS();
+            Expression *rhs = compound->getRHS();
+            const OperandKind right = kindOf(rhs);
+            if (right == CONST_OPERAND) node.b = ((ConstantExp *) rhs)->getValue();
+            else if (right == VAR_OPERAND) node.b = ((IdentifierExp *) rhs)->getSlot();
+            else node.rhs = build(rhs);
+            if (op == "=") {
+                if (lhs->getType() != IDENTIFIER) {
+                    node.fn = illegalAssignment;
+                } else if (lhs->toString() == "LET") {
+                    node.fn = assignToLet;
+                } else {
+                    node.a = ((IdentifierExp *) lhs)->getSlot();
+                    node.fn = right == CONST_OPERAND ? assign<ConstRight>
+                              : right == VAR_OPERAND ? assign<VarRight> : assign<NodeRight>;
+                }
+                break;
+            }
+            const OperandKind left = kindOf(lhs);
+            if (left == CONST_OPERAND) node.a = ((ConstantExp *) lhs)->getValue();
+            else if (left == VAR_OPERAND) node.a = ((IdentifierExp *) lhs)->getSlot();
+            else node.lhs = build(lhs);
+            if (op == "+") node.fn = pickBinary<ADD_OP>(left, right);
+            else if (op == "-") node.fn = pickBinary<SUB_OP>(left, right);
+            else if (op == "*") node.fn = pickBinary<MUL_OP>(left, right);
+            else if (op == "/") node.fn = pickBinary<DIV_OP>(left, right);
+            else node.fn = pickBinary<OTHER_OP>(left, right);
+            break;
+        }
+    }
+    nodes.push_back(node);
+    return &nodes.back();
+}
@@ -0,0 +1,78 @@
+/*
+ * File: closure.h
+ * ---------------
+ * This interface exports the Closure class, a compiled form of an
+ * expression for the tree-walking evaluator.  The interpreter builds
+ * one per expression when it is started with --closures.
+ */
+
+#ifndef _closure_h
+#define _closure_h
+
+#include <vector>
+#include "exp.hpp"
+#include "evalstate.hpp"
+
+/*
+ * Class: Closure
+ * --------------
+ * An expression turned into a tree of pre-bound closures.  Each node
+ * is a function specialized on its operator and on the kind of each
+ * operand (constant, variable or another node), together with the
+ * constants and slots it needs.  Evaluating the expression is then a
+ * chain of direct calls, with none of the string comparisons and
+ * virtual type checks of Expression::eval, and it raises the same
+ * errors in the same order.
+ */
+
+class Closure {
+
+public:
+
+/*
+ * Constructor: Closure
+ * Usage: Closure closure(exp);
+ * ----------------------------
+ * Compiles the expression.  The closure does not refer to exp
+ * afterwards, so exp may be deleted independently.
+ */
+
+    explicit Closure(Expression *exp);
+
+/*
+ * Method: eval
+ * Usage: int value = closure.eval(state);
+ * ---------------------------------------
+ * Evaluates the compiled expression in the context of state.
+ */
+
+    int eval(EvalState &state) const {
+        return root->fn(*root, state);
+    }
+
+/*
+ * Type: Node
+ * ----------
+ * One closure.  The left operand is the constant or slot in a, or the
+ * node lhs; the right operand is b or rhs.  An assignment keeps the
+ * slot it assigns in a.
+ */
+
+    struct Node {
+        int (*fn)(const Node &node, EvalState &state);
+        int a;
+        int b;
+        const Node *lhs;
+        const Node *rhs;
+    };
+
+private:
+
+    std::vector<Node> nodes; // 所有结点放在一起，建好后不再扩容
+    const Node *root;
+
+    const Node *build(Expression *exp);
+
+};
+
+#endif
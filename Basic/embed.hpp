@@ -0,0 +1,694 @@
+/*
+ * File: embed.h
+ * -------------
+ * This interface exports BasicProgram, which embeds a BASIC program
+ * in a C++ program.  The source is a string constant that the C++
+ * compiler tokenizes and parses with the grammar of readE and readT,
+ * and every line and every expression node is then instantiated as
+ * code of its own.  Running an embedded program parses nothing and
+ * allocates nothing on the heap.
+ *
+ * The header stands on its own: it needs neither the rest of the
+ * interpreter nor anything beyond the standard library.
+ */
+
+#ifndef _embed_h
+#define _embed_h
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include "keyword.hpp"
+
+/*
+ * Class: EmbeddedBasic
+ * --------------------
+ * The compile-time half of BasicProgram: the types of a parsed
+ * program and the constexpr parser that produces one.  Clients use
+ * BasicProgram and do not normally need anything in here.
+ */
+
+class EmbeddedBasic {
+
+public:
+
+/*
+ * Type: Op
+ * --------
+ * The operation of an expression node.  An assignment whose left
+ * operand is not a variable, or is the variable LET, cannot succeed;
+ * the parser gives it its own operation, which reports the error the
+ * interpreter reports when the expression is evaluated.
+ */
+
+    enum Op : unsigned char {
+        CONSTANT, VARIABLE, ADD, SUBTRACT, MULTIPLY, DIVIDE, ASSIGN, BAD_ASSIGN, LET_ASSIGN
+    };
+
+/*
+ * Type: Kind
+ * ----------
+ * The kind of statement on a program line.
+ */
+
+    enum Kind : unsigned char {
+        LET, PRINT, INPUT, REM, GOTO, IF, END
+    };
+
+/*
+ * Type: Node
+ * ----------
+ * One expression node.  value is the constant or the variable slot,
+ * and lhs and rhs index the operands in the node array.
+ */
+
+    struct Node {
+        Op op = CONSTANT;
+        int value = 0;
+        int lhs = -1;
+        int rhs = -1;
+    };
+
+/*
+ * Type: Line
+ * ----------
+ * One program line.  lhs holds the expression of LET and PRINT and
+ * the left side of IF; slot is the variable of LET and INPUT.  target
+ * is the index of the line GOTO and IF jump to, or -1 if the program
+ * has no line targetLine.
+ */
+
+    struct Line {
+        int number = 0;
+        Kind kind = REM;
+        int slot = -1;
+        int lhs = -1;
+        char relop = 0;
+        int rhs = -1;
+        int targetLine = -1;
+        int target = -1;
+    };
+
+/*
+ * Type: Image
+ * -----------
+ * A parsed program whose source is shorter than N characters.  The
+ * lines are sorted by line number, with only the last definition of
+ * each number kept, as they would be after typing the source at the
+ * prompt.  Variables are numbered from 0 in order of appearance.
+ */
+
+    template <std::size_t N>
+    struct Image {
+        Node nodes[2 * N] = {}; // 一元负号一个字符就要两个结点
+        Line lines[N] = {};
+        int nodeCount = 0;
+        int lineCount = 0;
+        int slotCount = 0;
+        int nameBegin[N] = {}; // 每个变量名在源程序中的位置
+        int nameEnd[N] = {};
+    };
+
+/*
+ * Function: length
+ * Usage: constexpr std::size_t n = EmbeddedBasic::length(source);
+ * ---------------------------------------------------------------
+ * Returns the length of a null-terminated string.
+ */
+
+    static constexpr std::size_t length(const char *text) {
+        std::size_t n = 0;
+        while (text[n] != '\0') ++n;
+        return n;
+    }
+
+/*
+ * Function: parse
+ * Usage: constexpr auto image = EmbeddedBasic::parse<N>(source);
+ * --------------------------------------------------------------
+ * Parses the program in source, which must be shorter than N
+ * characters.  Every line of the source must be a numbered program
+ * line; a line holding only a number deletes that line, as at the
+ * prompt.  A line that the interpreter would reject makes the
+ * constant evaluation fail, so a broken program does not compile.
+ * The compiler's diagnostic names the check that failed and its
+ * message.
+ */
+
+    template <std::size_t N>
+    static constexpr Image<N> parse(const char *source) {
+        Parser<N> parser{source};
+        const int end = int(length(source));
+        for (int begin = 0; begin < end;) {
+            int stop = begin;
+            while (stop < end && source[stop] != '\n') ++stop;
+            parser.parseLine(begin, stop);
+            begin = stop + 1;
+        }
+        parser.finish();
+        return parser.image;
+    }
+
+/*
+ * Function: check
+ * Usage: check(condition, message);
+ * ---------------------------------
+ * Stops a constant evaluation with message unless condition holds.
+ */
+
+    static constexpr void check(bool condition, const char *message) {
+        if (!condition) throw message;
+    }
+
+private:
+
+/*
+ * Type: Token
+ * -----------
+ * A token of the source, given by its kind and the range of
+ * characters it covers.  The kinds follow TokenScanner with
+ * ignoreWhitespace and scanNumbers set, which is how the
+ * interpreter scans a line.
+ */
+
+    enum TokenKind : unsigned char {
+        NO_TOKEN, NUMBER, WORD, OPERATOR
+    };
+
+    struct Token {
+        TokenKind kind = NO_TOKEN;
+        int begin = 0;
+        int end = 0;
+    };
+
+    static constexpr bool isDigit(char ch) {
+        return ch >= '0' && ch <= '9';
+    }
+
+    static constexpr bool isWordCharacter(char ch) {
+        return isDigit(ch) || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+    }
+
+    static constexpr bool isSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f' || ch == '\n';
+    }
+
+/*
+ * Class: Parser
+ * -------------
+ * The state of one parse: the image being filled in and a scanner
+ * position within the current line.
+ */
+
+    template <std::size_t N>
+    struct Parser {
+        const char *text;
+        Image<N> image = {};
+        int pos = 0;
+        int end = 0;
+
+        constexpr explicit Parser(const char *text) : text(text) {}
+
+/*
+ * Method: next
+ * ------------
+ * Scans the next token the way TokenScanner::nextToken does.  A number
+ * may run on into a fraction and an exponent, which stringToInteger
+ * then rejects.
+ */
+
+        constexpr Token next() {
+            while (pos < end && isSpace(text[pos])) ++pos;
+            Token token{NO_TOKEN, pos, pos};
+            if (pos == end) {
+                return token;
+            }
+            if (isDigit(text[pos])) {
+                token.kind = NUMBER;
+                while (pos < end && isDigit(text[pos])) ++pos;
+                if (pos < end && text[pos] == '.') {
+                    ++pos;
+                    while (pos < end && isDigit(text[pos])) ++pos;
+                }
+                if (pos < end && (text[pos] == 'e' || text[pos] == 'E')) {
+                    int exponent = pos + 1;
+                    if (exponent < end && (text[exponent] == '+' || text[exponent] == '-')) ++exponent;
+                    if (exponent < end && isDigit(text[exponent])) { // 指数不完整时 e 不算数字的一部分
+                        pos = exponent;
+                        while (pos < end && isDigit(text[pos])) ++pos;
+                    }
+                }
+            } else if (isWordCharacter(text[pos])) {
+                token.kind = WORD;
+                while (pos < end && isWordCharacter(text[pos])) ++pos;
+            } else {
+                token.kind = OPERATOR;
+                ++pos;
+            }
+            token.end = pos;
+            return token;
+        }
+
+        constexpr bool hasMoreTokens() {
+            const int saved = pos;
+            const bool more = next().kind != NO_TOKEN;
+            pos = saved;
+            return more;
+        }
+
+        constexpr bool is(const Token &token, const char *word) const {
+            int i = 0;
+            for (; word[i] != '\0'; ++i) {
+                if (token.begin + i >= token.end || text[token.begin + i] != word[i]) return false;
+            }
+            return token.begin + i == token.end;
+        }
+
+/*
+ * Method: toInteger
+ * -----------------
+ * Converts a token the way stringToInteger does: it must consist of
+ * decimal digits only and fit in an int.
+ */
+
+        constexpr int toInteger(const Token &token) const {
+            check(token.kind == NUMBER, "stringToInteger: Illegal integer format");
+            long long value = 0;
+            for (int i = token.begin; i < token.end; ++i) {
+                check(isDigit(text[i]), "stringToInteger: Illegal integer format");
+                value = value * 10 + (text[i] - '0');
+                check(value <= 2147483647LL, "stringToInteger: Illegal integer format");
+            }
+            return int(value);
+        }
+
+        constexpr int slotOf(const Token &token) {
+            const int size = token.end - token.begin;
+            for (int slot = 0; slot < image.slotCount; ++slot) {
+                if (image.nameEnd[slot] - image.nameBegin[slot] != size) continue;
+                int i = 0;
+                while (i < size && text[image.nameBegin[slot] + i] == text[token.begin + i]) ++i;
+                if (i == size) return slot;
+            }
+            image.nameBegin[image.slotCount] = token.begin;
+            image.nameEnd[image.slotCount] = token.end;
+            return image.slotCount++;
+        }
+
+        constexpr int node(Op op, int value, int lhs, int rhs) {
+            image.nodes[image.nodeCount] = Node{op, value, lhs, rhs};
+            return image.nodeCount++;
+        }
+
+        static constexpr int precedence(char op) {
+            return op == '=' ? 1 : op == '+' || op == '-' ? 2 : op == '*' || op == '/' ? 3 : 0;
+        }
+
+/*
+ * Methods: readE, readT, parseExp
+ * -------------------------------
+ * The same grammar as the functions of the same names in parser.h,
+ * producing node indices.  Where those return a ParseResult with an
+ * error, these stop the compilation with a message naming it.  As
+ * there, floor is the level the whole expression stops at, which a
+ * unary minus inside it reads down to.
+ */
+
+        constexpr int readE(int prec, int floor) {
+            int exp = readT(floor);
+            while (true) {
+                const int saved = pos;
+                const Token token = next();
+                const int newPrec = token.kind == OPERATOR ? precedence(text[token.begin]) : 0;
+                if (newPrec <= prec) {
+                    pos = saved;
+                    return exp;
+                }
+                const int rhs = readE(newPrec, floor);
+                exp = compound(text[token.begin], exp, rhs);
+            }
+        }
+
+        constexpr int readT(int floor) {
+            const Token token = next();
+            if (token.kind == WORD) return node(VARIABLE, slotOf(token), -1, -1);
+            if (token.kind == NUMBER) return node(CONSTANT, toInteger(token), -1, -1);
+            if (is(token, "-")) {
+                const int zero = node(CONSTANT, 0, -1, -1);
+                return node(SUBTRACT, 0, zero, readE(floor, floor));
+            }
+            check(is(token, "("), "Illegal term in expression");
+            const int exp = readE(0, 0);
+            check(is(next(), ")"), "Unbalanced parentheses in expression");
+            return exp;
+        }
+
+        constexpr int parseExp() {
+            const int exp = readE(0, 0);
+            check(!hasMoreTokens(), "parseExp: Found extra token");
+            return exp;
+        }
+
+        constexpr int compound(char op, int lhs, int rhs) {
+            if (op == '=') {
+                const Node &target = image.nodes[lhs];
+                if (target.op != VARIABLE) return node(BAD_ASSIGN, 0, lhs, rhs);
+                const int size = image.nameEnd[target.value] - image.nameBegin[target.value];
+                const char *name = text + image.nameBegin[target.value];
+                if (size == 3 && name[0] == 'L' && name[1] == 'E' && name[2] == 'T') return node(LET_ASSIGN, 0, lhs, rhs);
+                return node(ASSIGN, target.value, lhs, rhs);
+            }
+            return node(op == '+' ? ADD : op == '-' ? SUBTRACT : op == '*' ? MULTIPLY : DIVIDE, 0, lhs, rhs);
+        }
+
+/*
+ * Method: parseLine
+ * -----------------
+ * Parses the source line between begin and stop as processLine
+ * parses a numbered line.  The condition of IF is read the way
+ * readCondition reads it.
+ */
+
+        constexpr void parseLine(int begin, int stop) {
+            pos = begin;
+            end = stop;
+            const Token number = next();
+            if (number.kind == NO_TOKEN) {
+                return; // 空行
+            }
+            check(number.kind == NUMBER, "only numbered program lines can be embedded");
+            Line line;
+            line.number = toInteger(number);
+            if (!hasMoreTokens()) {
+                remove(line.number);
+                return;
+            }
+            const Token token = next();
+            const Keyword keyword = keywordOf(std::string_view(text + token.begin, token.end - token.begin));
+            if (keyword == LET_KEYWORD) {
+                line.kind = LET;
+                line.slot = slotOf(next());
+                check(is(next(), "="), "SYNTAX ERROR");
+                line.lhs = parseExp();
+            } else if (keyword == PRINT_KEYWORD) {
+                line.kind = PRINT;
+                line.lhs = parseExp();
+            } else if (keyword == INPUT_KEYWORD) {
+                line.kind = INPUT;
+                check(hasMoreTokens(), "SYNTAX ERROR");
+                line.slot = slotOf(next());
+            } else if (keyword == REM_KEYWORD) {
+                line.kind = REM;
+            } else if (keyword == GOTO_KEYWORD) {
+                line.kind = GOTO;
+                check(hasMoreTokens(), "SYNTAX ERROR");
+                line.targetLine = toInteger(next());
+                check(!hasMoreTokens(), "SYNTAX ERROR");
+            } else if (keyword == IF_KEYWORD) {
+                line.kind = IF;
+                check(hasMoreTokens(), "SYNTAX ERROR");
+                line.lhs = readE(1, 1); // 关系运算符这一层，见 readCondition
+                const Token relop = next();
+                check(is(relop, "=") || is(relop, "<") || is(relop, ">"), "SYNTAX ERROR");
+                line.relop = text[relop.begin];
+                line.rhs = readE(0, 0);
+                check(is(next(), "THEN"), "SYNTAX ERROR");
+                line.targetLine = toInteger(next());
+                check(!hasMoreTokens(), "SYNTAX ERROR");
+            } else if (keyword == END_KEYWORD) {
+                line.kind = END;
+            } else {
+                check(false, "SYNTAX ERROR");
+            }
+            remove(line.number);
+            image.lines[image.lineCount++] = line;
+        }
+
+        constexpr void remove(int number) {
+            int kept = 0;
+            for (int i = 0; i < image.lineCount; ++i) {
+                if (image.lines[i].number != number) image.lines[kept++] = image.lines[i];
+            }
+            image.lineCount = kept;
+        }
+
+/*
+ * Method: finish
+ * --------------
+ * Sorts the lines by number and resolves the targets of GOTO and IF
+ * to line indices.
+ */
+
+        constexpr void finish() {
+            for (int i = 1; i < image.lineCount; ++i) {
+                const Line line = image.lines[i];
+                int j = i;
+                for (; j > 0 && image.lines[j - 1].number > line.number; --j) {
+                    image.lines[j] = image.lines[j - 1];
+                }
+                image.lines[j] = line;
+            }
+            for (int i = 0; i < image.lineCount; ++i) {
+                Line &line = image.lines[i];
+                for (int j = 0; j < image.lineCount && line.targetLine >= 0; ++j) {
+                    if (image.lines[j].number == line.targetLine) line.target = j;
+                }
+            }
+        }
+    };
+
+};
+
+/*
+ * Class: BasicProgram
+ * -------------------
+ * A BASIC program embedded at compile time.  Source must point to a
+ * constant string with linkage, for example one declared at namespace
+ * scope:
+ *
+ *     static constexpr char countdown[] = "10 LET n = 3\n"
+ *                                         "20 PRINT n\n"
+ *                                         "30 LET n = n - 1\n"
+ *                                         "40 IF n > 0 THEN 20\n";
+ *
+ *     BasicProgram<countdown>::run(std::cin, std::cout);
+ *
+ * The expression of each line becomes straight-line code with its
+ * variables and constants built in, and each line a function that
+ * returns the index of the line to run next.
+ */
+
+template <const char *Source>
+class BasicProgram {
+
+public:
+
+/*
+ * Method: run
+ * Usage: const char *error = BasicProgram<source>::run(in, out);
+ * --------------------------------------------------------------
+ * Runs the program with no variables defined, as RUN does in a fresh
+ * interpreter: the same output, the same prompts for INPUT read from
+ * in, the same limit of 1000 executions per line and the same error
+ * messages.  The message of an error that stops the program is
+ * written to out and also returned; a program that runs to the end
+ * returns NULL.  Where the interpreter would keep prompting at the
+ * end of the input, run stops with INVALID NUMBER.
+ */
+
+    static const char *run(std::istream &in, std::ostream &out) {
+        State state = {in, out};
+        const char *error = nullptr;
+        if constexpr (image.lineCount > 0) {
+            error = execute(state, std::make_index_sequence<image.lineCount>());
+        }
+        if (error != nullptr) {
+            out << error << std::endl;
+        }
+        return error;
+    }
+
+/*
+ * Method: lineCount
+ * Usage: constexpr int n = BasicProgram<source>::lineCount();
+ * -----------------------------------------------------------
+ * Returns the number of lines in the program.
+ */
+
+    static constexpr int lineCount() {
+        return image.lineCount;
+    }
+
+private:
+
+    static constexpr std::size_t capacity = EmbeddedBasic::length(Source) + 1;
+    static constexpr EmbeddedBasic::Image<capacity> image = EmbeddedBasic::parse<capacity>(Source);
+
+    struct State {
+        std::istream &in;
+        std::ostream &out;
+        int values[image.slotCount > 0 ? image.slotCount : 1] = {};
+        bool defined[image.slotCount > 0 ? image.slotCount : 1] = {};
+        unsigned runs[image.lineCount > 0 ? image.lineCount : 1] = {}; // 每行的执行次数
+    };
+
+    using Step = int (*)(State &state, const char *&error);
+
+    template <std::size_t... Index>
+    static const char *execute(State &state, std::index_sequence<Index...>) {
+        static constexpr Step steps[] = {&step<int(Index)>...};
+        const char *error = nullptr;
+        for (int line = 0; line >= 0;) {
+            line = steps[line](state, error);
+        }
+        return error;
+    }
+
+/*
+ * Implementation notes: eval
+ * --------------------------
+ * Evaluates node Index into value and returns NULL, or returns the
+ * message of the error it ran into.  The operands are evaluated left
+ * to right and every check of Expression::eval is made in the same
+ * order.  Arithmetic is done on unsigned values so that it wraps the
+ * way the interpreter's does.
+ */
+
+    template <int Index>
+    static const char *eval(State &state, int &value) {
+        constexpr EmbeddedBasic::Node node = image.nodes[Index];
+        if constexpr (node.op == EmbeddedBasic::CONSTANT) {
+            value = node.value;
+            return nullptr;
+        } else if constexpr (node.op == EmbeddedBasic::VARIABLE) {
+            if (!state.defined[node.value]) return "VARIABLE NOT DEFINED";
+            value = state.values[node.value];
+            return nullptr;
+        } else if constexpr (node.op == EmbeddedBasic::BAD_ASSIGN) {
+            return "Illegal variable in assignment";
+        } else if constexpr (node.op == EmbeddedBasic::LET_ASSIGN) {
+            return "SYNTAX ERROR";
+        } else if constexpr (node.op == EmbeddedBasic::ASSIGN) {
+            if (const char *error = eval<node.rhs>(state, value)) return error;
+            state.values[node.value] = value;
+            state.defined[node.value] = true;
+            return nullptr;
+        } else {
+            int left = 0;
+            int right = 0;
+            if (const char *error = eval<node.lhs>(state, left)) return error;
+            if (const char *error = eval<node.rhs>(state, right)) return error;
+            if constexpr (node.op == EmbeddedBasic::ADD) {
+                value = int(unsigned(left) + unsigned(right));
+            } else if constexpr (node.op == EmbeddedBasic::SUBTRACT) {
+                value = int(unsigned(left) - unsigned(right));
+            } else if constexpr (node.op == EmbeddedBasic::MULTIPLY) {
+                value = int(unsigned(left) * unsigned(right));
+            } else {
+                if (right == 0) return "DIVIDE BY ZERO";
+                value = left / right;
+            }
+            return nullptr;
+        }
+    }
+
+/*
+ * Implementation notes: step
+ * --------------------------
+ * Runs line Index and returns the index of the line to run next, or
+ * -1 when the program stops, with error set if it stopped on one.
+ * A taken IF to a line that does not exist ends the program quietly
+ * and a GOTO to one is an error, as in the interpreter.
+ */
+
+    template <int Index>
+    static int step(State &state, const char *&error) {
+        constexpr EmbeddedBasic::Line line = image.lines[Index];
+        constexpr int next = Index + 1 < image.lineCount ? Index + 1 : -1;
+        if (++state.runs[Index] >= 1000) {
+            error = "SYNTAX ERROR";
+            return -1;
+        }
+        int value = 0;
+        if constexpr (line.kind == EmbeddedBasic::LET) {
+            if ((error = eval<line.lhs>(state, value)) != nullptr) return -1;
+            state.values[line.slot] = value;
+            state.defined[line.slot] = true;
+        } else if constexpr (line.kind == EmbeddedBasic::PRINT) {
+            if ((error = eval<line.lhs>(state, value)) != nullptr) return -1;
+            state.out << value << std::endl;
+        } else if constexpr (line.kind == EmbeddedBasic::INPUT) {
+            if (!readValue(state, value)) {
+                error = "INVALID NUMBER";
+                return -1;
+            }
+            state.values[line.slot] = value;
+            state.defined[line.slot] = true;
+        } else if constexpr (line.kind == EmbeddedBasic::GOTO) {
+            if constexpr (line.target < 0) {
+                error = "LINE NUMBER ERROR";
+            }
+            return line.target;
+        } else if constexpr (line.kind == EmbeddedBasic::IF) {
+            int right = 0;
+            if ((error = eval<line.lhs>(state, value)) != nullptr) return -1;
+            if ((error = eval<line.rhs>(state, right)) != nullptr) return -1;
+            if (line.relop == '=' ? value == right : line.relop == '<' ? value < right : value > right) {
+                return line.target;
+            }
+        } else if constexpr (line.kind == EmbeddedBasic::END) {
+            return -1;
+        }
+        return next;
+    }
+
+/*
+ * Implementation notes: readValue
+ * -------------------------------
+ * Reads one line of input character by character and accepts it on
+ * the same terms as InputStatement::readValue, which extracts an int
+ * from the line and requires that nothing follows it: optional
+ * leading white space, an optional sign and digits whose value fits
+ * in an int.  Returns false at the end of the input.
+ */
+
+    static bool readValue(State &state, int &value) {
+        while (true) {
+            state.out << " ? ";
+            int ch = state.in.get();
+            if (ch == std::char_traits<char>::eof()) {
+                return false;
+            }
+            bool valid = true;
+            bool negative = false;
+            int digits = 0;
+            long long magnitude = 0;
+            while (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f') {
+                ch = state.in.get();
+            }
+            if (ch == '+' || ch == '-') {
+                negative = ch == '-';
+                ch = state.in.get();
+            }
+            for (; ch != '\n' && ch != std::char_traits<char>::eof(); ch = state.in.get()) {
+                if (ch < '0' || ch > '9') {
+                    valid = false;
+                    continue;
+                }
+                ++digits;
+                if (magnitude <= 2147483648LL) { // 已经溢出就不用再往上加了
+                    magnitude = magnitude * 10 + (ch - '0');
+                }
+            }
+            if (valid && digits > 0 && magnitude <= (negative ? 2147483648LL : 2147483647LL)) {
+                value = int(negative ? -magnitude : magnitude);
+                return true;
+            }
+            state.out << "INVALID NUMBER" << std::endl;
+        }
+    }
+
+};
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * File: emitter.cpp
+ * -----------------
+ * This file implements the C++ back end declared in emitter.h.
+ */
+
+#include <map>
+#include <sstream>
+#include "emitter.hpp"
+#include "statement.hpp"
+
+
+/*
+ * Implementation notes: expressions
+ * ---------------------------------
+ * Expressions are emitted as three-address code, one temporary per
+ * operation, because C++ leaves the order in which the operands of +
+ * are evaluated unspecified and BASIC evaluates them left to right.
+ * That order decides which error is reported first, and an assignment
+ * nested in an expression must not change a variable that was read
+ * before it.  Every operation is checked where Expression::eval checks
+ * it, and an error returns from main after printing its message.
+ * Additions, subtractions and multiplications are done on unsigned
+ * values so that they wrap, as they do in the interpreter, instead of
+ * overflowing.
+ */
+
+class CppEmitter {
+
+public:
+
+    explicit CppEmitter(std::ostream &out) : out(out), temps(0) {}
+
+    std::map<int, std::string> variables; // 用到的槽位 -> 变量名
+
+    void beginStatement() {
+        temps = 0;
+    }
+
+    std::string emit(Expression *exp) {
+        switch (exp->getType()) {
+            case CONSTANT:
+                return "int(" + std::to_string(((ConstantExp *) exp)->getValue()) + ")";
+            case IDENTIFIER: {
+                const std::string var = use(((IdentifierExp *) exp)->getSlot(), exp->toString());
+                const std::string temp = newTemp();
+                out << "                if (!d" << var << ") return fail(\"VARIABLE NOT DEFINED\");\n"
+                    << "                const int " << temp << " = v" << var << ";\n";
+                return temp;
+            }
+            case COMPOUND:
+                break;
+        }
+        auto *compound = (CompoundExp *) exp;
+        const std::string op = compound->getOp();
+        Expression *lhs = compound->getLHS();
+        if (op == "=") {
+            if (lhs->getType() != IDENTIFIER) {
+                out << "                return fail(\"Illegal variable in assignment\");\n";
+                return "0";
+            }
+            if (lhs->toString() == "LET") {
+                out << "                return fail(\"SYNTAX ERROR\");\n";
+                return "0";
+            }
+            const std::string value = emit(compound->getRHS());
+            assign(((IdentifierExp *) lhs)->getSlot(), lhs->toString(), value);
+            return value;
+        }
+        const std::string left = emit(lhs);
+        const std::string right = emit(compound->getRHS());
+        const std::string temp = newTemp();
+        if (op == "/") {
+            out << "                if (" << right << " == 0) return fail(\"DIVIDE BY ZERO\");\n"
+                << "                const int " << temp << " = " << left << " / " << right << ";\n";
+        } else if (op == "+" || op == "-" || op == "*") {
+            out << "                const int " << temp << " = int(unsigned(" << left << ") " << op
+                << " unsigned(" << right << "));\n";
+        } else {
+            out << "                const int " << temp << " = 0;\n";
+        }
+        return temp;
+    }
+
+    void assign(int slot, const std::string &name, const std::string &value) {
+        const std::string var = use(slot, name);
+        out << "                v" << var << " = " << value << ";\n"
+            << "                d" << var << " = true;\n";
+    }
+
+private:
+
+    std::ostream &out;
+    int temps;
+
+    std::string newTemp() {
+        return "t" + std::to_string(++temps);
+    }
+
+    std::string use(int slot, const std::string &name) {
+        variables.emplace(slot, name);
+        return std::to_string(slot);
+    }
+
+};
+
+/*
+ * Implementation notes: emitCpp
+ * -----------------------------
+ * The body of main is generated first, so that the variables it uses
+ * are known when their declarations are written.  The source text of
+ * each line is copied into a comment with its backslashes replaced,
+ * since a backslash at the end of a // comment would continue it onto
+ * the next line of code.
+ */
+
+static std::string commentText(std::string text) {
+    for (char &ch : text) {
+        if (ch == '\\') ch = '/';
+    }
+    return text;
+}
+
+void emitCpp(Program &program, const std::string &source, std::ostream &out) {
+    std::ostringstream body;
+    CppEmitter emitter(body);
+    int first = -1;
+    int count = 0; // 语句个数，也是执行计数器的个数
+    for (int lineNumber = program.getFirstLineNumber(); lineNumber != -1;
+         lineNumber = program.getNextLineNumber(lineNumber)) {
+        Statement *stmt = program.getParsedStatement(lineNumber);
+        if (stmt == nullptr) {
+            continue;
+        }
+        if (first < 0) {
+            first = lineNumber;
+        }
+        emitter.beginStatement();
+        body << "            case " << lineNumber << ": { // " << commentText(std::string(program.getSourceLine(lineNumber))) << "\n"
+             << "                if (++runs[" << count++ << "] >= 1000) return fail(\"SYNTAX ERROR\");\n";
+        switch (stmt->getType()) {
+            case LET_STMT: {
+                const auto *let = static_cast<LetStatement *>(stmt);
+                const std::string value = emitter.emit(let->getExp());
+                emitter.assign(let->getSlot(), let->getVariable(), value);
+                break;
+            }
+            case PRINT_STMT: {
+                const std::string value = emitter.emit(static_cast<PrintStatement *>(stmt)->getExp());
+                body << "                std::cout << " << value << " << std::endl;\n";
+                break;
+            }
+            case INPUT_STMT: {
+                const auto *input = static_cast<InputStatement *>(stmt);
+                emitter.assign(input->getSlot(), input->getVariable(), "readValue()");
+                break;
+            }
+            case REM_STMT:
+                break;
+            case GOTO_STMT: {
+                const int target = stmt->getTargetLine();
+                if (program.getParsedStatement(target) != nullptr) {
+                    body << "                line = " << target << ";\n"
+                         << "                continue;\n";
+                } else {
+                    body << "                return fail(\"LINE NUMBER ERROR\");\n";
+                }
+                break;
+            }
+            case IF_STMT: {
+                const auto *ifStmt = static_cast<IfStatement *>(stmt);
+                const std::string left = emitter.emit(ifStmt->getLHS());
+                const std::string right = emitter.emit(ifStmt->getRHS());
+                const TokenKind relation = ifStmt->getRelation();
+                body << "                if (" << left
+                     << (relation == EQUALS_TOKEN ? " == " : relation == LESS_TOKEN ? " < " : " > ") << right << ") {\n";
+                const int target = stmt->getTargetLine();
+                if (program.getParsedStatement(target) != nullptr) {
+                    body << "                    line = " << target << ";\n"
+                         << "                    continue;\n";
+                } else {
+                    body << "                    return 0;\n"; // 跳到不存在的行，静静结束
+                }
+                body << "                }\n";
+                break;
+            }
+            case END_STMT:
+                body << "                return 0;\n";
+                break;
+        }
+        body << "            }\n";
+    }
+
+    out << "/*\n"
+        << " * Generated by basic --emit-cpp from " << commentText(source) << ".\n"
+        << " * Build it with any C++11 compiler; it runs the program once.\n"
+        << " */\n"
+        << "\n"
+        << "#include <iostream>\n"
+        << "#include <sstream>\n"
+        << "#include <string>\n"
+        << "\n"
+        << "static int fail(const char *message) {\n"
+        << "    std::cout << message << std::endl;\n"
+        << "    return 0;\n"
+        << "}\n"
+        << "\n"
+        << "static int readValue() {\n"
+        << "    int value;\n"
+        << "    std::string input;\n"
+        << "    while (true) {\n"
+        << "        std::cout << \" ? \";\n"
+        << "        getline(std::cin, input);\n"
+        << "        std::istringstream iss(input);\n"
+        << "        if (iss >> value && iss.eof()) {\n"
+        << "            return value;\n"
+        << "        }\n"
+        << "        std::cout << \"INVALID NUMBER\" << std::endl;\n"
+        << "    }\n"
+        << "}\n"
+        << "\n"
+        << "int main() {\n";
+    if (first < 0) {
+        out << "    return 0;\n"
+            << "}\n";
+        return;
+    }
+    out << "    static unsigned runs[" << count << "] = {};\n";
+    for (const auto &variable : emitter.variables) {
+        out << "    int v" << variable.first << " = 0;\n"
+            << "    bool d" << variable.first << " = false; // " << commentText(variable.second) << "\n";
+    }
+    out << "    int line = " << first << ";\n"
+        << "    for (;;) {\n"
+        << "        switch (line) {\n"
+        << body.str()
+        << "        }\n"
+        << "        return 0;\n"
+        << "    }\n"
+        << "}\n";
+}
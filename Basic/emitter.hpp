@@ -0,0 +1,32 @@
+/*
+ * File: emitter.h
+ * ---------------
+ * This interface exports emitCpp, which translates a BASIC program
+ * into a self-contained C++ program.  The interpreter does this when
+ * it is started with --emit-cpp.
+ */
+
+#ifndef _emitter_h
+#define _emitter_h
+
+#include <iostream>
+#include <string>
+#include "program.hpp"
+
+/*
+ * Function: emitCpp
+ * Usage: emitCpp(program, source, out);
+ * -------------------------------------
+ * Writes to out a C++ translation unit whose main function behaves like
+ * RUN on the program in a fresh interpreter: the same output, the same
+ * prompts for INPUT and the same error messages, including the limit
+ * of 1000 executions per line.  The program is a state machine that
+ * switches on the line number; consecutive lines fall through into one
+ * another and GOTO and IF jump back to the switch.  Variables become
+ * local variables.  source names the file the program came from and
+ * only appears in a comment.
+ */
+
+void emitCpp(Program &program, const std::string &source, std::ostream &out);
+
+#endif
@@ -1,12 +1,15 @@
 /*
  * File: evalstate.cpp
  * -------------------
- * This file implements the EvalState class, which defines a symbol
- * table for keeping track of the value of identifiers.  The public
- * methods are simple enough that they need no individual documentation.
+ * This file implements the EvalState class, which keeps track of the
+ * value of identifiers.  The public methods are simple enough that
+ * they need no individual documentation.
  */
 
 
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
 #include "evalstate.hpp"
 
 
@@ -23,19 +26,80 @@ EvalState::~EvalState() {
 }
 
 void EvalState::setValue(std::string var, int value) {
-    if(isDefined(var)) symbolTable[var] = value;
-    else symbolTable.emplace(var,value);
+    setValue(slotOf(var), value);
 }
 
 int EvalState::getValue(std::string var) {
-    if(isDefined(var)) return symbolTable[var];
+    if (isDefined(var)) return getValue(slotOf(var));
     else return 0;
 }
 
 bool EvalState::isDefined(std::string var) {
-    return symbolTable.find(var)!=symbolTable.end();
+    auto it = slotTable().find(var);
+    return it != slotTable().end() && isDefined(it->second);
 }
 
 void EvalState::Clear() {
-    symbolTable.clear();
-}
\ No newline at end of file
+    values.clear();
+    defined.clear();
+}
+
+/*
+ * Implementation notes: slotOf
+ * ----------------------------
+ * A parallel LOAD parses lines on several threads, and they all
+ * intern their names here.  Names are nearly always known already,
+ * so lookups share the lock and only a new name takes it alone, and
+ * looks again in case another thread added the name in between.
+ */
+
+int EvalState::slotOf(const std::string &name) {
+    static std::shared_mutex lock;
+    {
+        std::shared_lock<std::shared_mutex> reading(lock);
+        auto it = slotTable().find(name);
+        if (it != slotTable().end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> writing(lock);
+    auto it = slotTable().find(name);
+    if (it != slotTable().end()) {
+        return it->second;
+    }
+    const int slot = int(slotNames().size());
+    slotNames().push_back(name);
+    slotTable().emplace(name, slot);
+    return slot;
+}
+
+const std::string &EvalState::nameOf(int slot) {
+    return slotNames()[slot];
+}
+
+int EvalState::slotCount() {
+    return int(slotNames().size());
+}
+
+/*
+ * Implementation notes: grow
+ * --------------------------
+ * Makes room for every slot interned so far, so that a state only
+ * grows once after a new program has been parsed.
+ */
+
+void EvalState::grow(int slot) {
+    std::size_t size = std::max(std::size_t(slot) + 1, slotNames().size());
+    values.resize(size, 0);
+    defined.resize((size + 63) / 64, 0);
+}
+
+std::unordered_map<std::string, int> &EvalState::slotTable() {
+    static std::unordered_map<std::string, int> table;
+    return table;
+}
+
+std::vector<std::string> &EvalState::slotNames() {
+    static std::vector<std::string> names;
+    return names;
+}
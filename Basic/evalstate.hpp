@@ -9,8 +9,10 @@
 #ifndef _evalstate_h
 #define _evalstate_h
 
+#include <cstdint>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 /*
  * Class: EvalState
@@ -19,9 +21,14 @@
  * of the evaluator and contains information from the evaluation
  * environment that the evaluator may need to know.  In this
  * version, the only information maintained by the EvalState class
- * is a symbol table that maps variable names into their values.
- * In your implementation, you may include additional information
- * in the EvalState class.
+ * is the values of the variables.
+ *
+ * Variable names are interned into dense integer slots when a
+ * program is parsed (see slotOf), and the values live in a flat
+ * array indexed by slot, next to a bitmap recording which slots
+ * have been assigned.  Reading a variable is then an indexed load
+ * and a bit test.  The name-based methods remain for INPUT and for
+ * commands typed in immediate mode.
  */
 
 class EvalState {
@@ -73,11 +80,81 @@ public:
 
     bool isDefined(std::string var);
 
+/*
+ * Methods: setValue, getValue, isDefined (slot versions)
+ * Usage: state.setValue(slot, value);
+ *        int value = state.getValue(slot);
+ *        if (state.isDefined(slot)) . . .
+ * --------------------------------------------
+ * The same operations on a variable identified by its slot.
+ * getValue may only be called on a slot that is defined.
+ */
+
+    void setValue(int slot, int value) {
+        if (std::size_t(slot) >= values.size()) {
+            grow(slot);
+        }
+        values[slot] = value;
+        defined[slot >> 6] |= uint64_t(1) << (slot & 63);
+    }
+
+    int getValue(int slot) const {
+        return values[slot];
+    }
+
+    bool isDefined(int slot) const {
+        return std::size_t(slot) < values.size() && (defined[slot >> 6] >> (slot & 63) & 1);
+    }
+
+/*
+ * Method: Clear
+ * Usage: state.Clear();
+ * ---------------------
+ * Removes the values of all variables.
+ */
+
     void Clear();
 
+/*
+ * Static method: slotOf
+ * Usage: int slot = EvalState::slotOf(name);
+ * ------------------------------------------
+ * Returns the slot of the variable with the given name, allocating
+ * the next free slot the first time a name is seen.  Slots are shared
+ * by every EvalState, so a program parsed once can be run against any
+ * of them.  Several threads may call slotOf at once; the numbers then
+ * depend on which thread sees a name first.
+ */
+
+    static int slotOf(const std::string &name);
+
+/*
+ * Static method: nameOf
+ * Usage: string name = EvalState::nameOf(slot);
+ * ---------------------------------------------
+ * Returns the name interned into the given slot.
+ */
+
+    static const std::string &nameOf(int slot);
+
+/*
+ * Static method: slotCount
+ * Usage: int count = EvalState::slotCount();
+ * ------------------------------------------
+ * Returns the number of slots interned so far.
+ */
+
+    static int slotCount();
+
 private:
 
-    std::map<std::string, int> symbolTable;
+    std::vector<int> values; // 按槽位存的变量值
+    std::vector<uint64_t> defined; // 每个槽位一位，表示是否赋过值
+
+    void grow(int slot);
+
+    static std::unordered_map<std::string, int> &slotTable();
+    static std::vector<std::string> &slotNames();
 
 };
 
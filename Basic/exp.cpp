@@ -48,18 +48,19 @@ int ConstantExp::getValue() {
 /*
  * Implementation notes: the IdentifierExp subclass
  * ------------------------------------------------
- * The IdentifierExp subclass declares a single instance variable that
- * stores the name of the variable.  The implementation of eval must
- * look this variable up in the evaluation state.
+ * The IdentifierExp subclass stores the name of the variable and the
+ * slot it was interned into.  The implementation of eval looks the
+ * slot up in the evaluation state.
  */
 
 IdentifierExp::IdentifierExp(std::string name) {
     this->name = name;
+    slot = EvalState::slotOf(name);
 }
 
 int IdentifierExp::eval(EvalState &state) {
-    if (!state.isDefined(name)) error("VARIABLE NOT DEFINED");
-    return state.getValue(name);
+    if (!state.isDefined(slot)) error("VARIABLE NOT DEFINED");
+    return state.getValue(slot);
 }
 
 std::string IdentifierExp::toString() {
@@ -109,7 +110,7 @@ int CompoundExp::eval(EvalState &state) {
         if (lhs->getType() == IDENTIFIER && lhs->toString() == "LET")
             error("SYNTAX ERROR");
         int val = rhs->eval(state);
-        state.setValue(((IdentifierExp *) lhs)->getName(), val);
+        state.setValue(((IdentifierExp *) lhs)->getSlot(), val);
         return val;
     }
     int left = lhs->eval(state);
@@ -143,3 +144,11 @@ Expression *CompoundExp::getLHS() {
 Expression *CompoundExp::getRHS() {
     return rhs;
 }
+
+void CompoundExp::setLHS(Expression *lhs) {
+    this->lhs = lhs;
+}
+
+void CompoundExp::setRHS(Expression *rhs) {
+    this->rhs = rhs;
+}
@@ -10,6 +10,7 @@
 #define _exp_h
 
 #include <string>
+#include "arena.hpp"
 #include "Utils/error.hpp"
 #include "evalstate.hpp"
 #include "Utils/strlib.hpp"
@@ -101,6 +102,20 @@ public:
 
     virtual ExpressionType getType() = 0;
 
+/*
+ * Operators: new, delete
+ * ----------------------
+ * Expression nodes are allocated from the current arena (see arena.h).
+ * Deleting a node runs its destructor and leaves the memory to the
+ * arena, which frees it together with the rest of the line.
+ */
+
+    static void *operator new(std::size_t size) {
+        return Arena::allocateNode(size);
+    }
+
+    static void operator delete(void *block) {}
+
 };
 
 /*
@@ -195,9 +210,22 @@ public:
 
     std::string getName();
 
+/*
+ * Method: getSlot
+ * Usage: int slot = ((IdentifierExp *) exp)->getSlot();
+ * -----------------------------------------------------
+ * Returns the variable slot the name was interned into when the
+ * node was created (see EvalState::slotOf).
+ */
+
+    int getSlot() const {
+        return slot;
+    }
+
 private:
 
     std::string name;
+    int slot;
 
 };
 
@@ -254,6 +282,20 @@ public:
 
     Expression *getRHS();
 
+/*
+ * Methods: setLHS, setRHS
+ * Usage: exp->setLHS(lhs);
+ *        exp->setRHS(rhs);
+ * ------------------------
+ * Replace one operand of the compound expression.  The old operand is
+ * not deleted; the caller is responsible for it.  These are used by
+ * simplifyExp when it rewrites a tree in place.
+ */
+
+    void setLHS(Expression *lhs);
+
+    void setRHS(Expression *rhs);
+
 private:
 
     std::string op;
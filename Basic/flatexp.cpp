@@ -0,0 +1,145 @@
+/*
+ * File: flatexp.cpp
+ * -----------------
+ * This file implements the ExpPool class declared in flatexp.h.
+ */
+
+#include "flatexp.hpp"
+#include "Utils/error.hpp"
+
+
+/*
+ * Implementation notes: add
+ * -------------------------
+ * The tree is flattened recursively: both operands first, then the
+ * node itself.  The left side of an assignment does not become a
+ * node, since Expression::eval never evaluates it, and neither side
+ * of an assignment that can only fail does.
+ */
+
+int ExpPool::add(Expression *exp) {
+    switch (exp->getType()) {
+        case CONSTANT:
+            constants.push_back(((ConstantExp *) exp)->getValue());
+            return push(CONST_NODE, constants.size() - 1, 0);
+        case IDENTIFIER:
+            slots.push_back(((IdentifierExp *) exp)->getSlot());
+            return push(VAR_NODE, slots.size() - 1, 0);
+        default:
+            break;
+    }
+    auto *compound = (CompoundExp *) exp;
+    const std::string op = compound->getOp();
+    if (op == "=") {
+        Expression *target = compound->getLHS();
+        if (target->getType() != IDENTIFIER) {
+            return push(ILLEGAL_ASSIGN_NODE, 0, 0);
+        }
+        if (target->toString() == "LET") {
+            return push(LET_ASSIGN_NODE, 0, 0);
+        }
+        const int value = add(compound->getRHS());
+        slots.push_back(((IdentifierExp *) target)->getSlot());
+        return push(ASSIGN_NODE, slots.size() - 1, value);
+    }
+    const int left = add(compound->getLHS());
+    const int right = add(compound->getRHS());
+    NodeOp nodeOp = OTHER_NODE;
+    if (op == "+") nodeOp = ADD_NODE;
+    else if (op == "-") nodeOp = SUB_NODE;
+    else if (op == "*") nodeOp = MUL_NODE;
+    else if (op == "/") nodeOp = DIV_NODE;
+    return push(nodeOp, left, right);
+}
+
+int ExpPool::push(NodeOp op, uint32_t left, uint32_t right) {
+    ops.push_back(op);
+    lhs.push_back(left);
+    rhs.push_back(right);
+    return int(ops.size()) - 1;
+}
+
+/*
+ * Implementation notes: eval
+ * --------------------------
+ * A post-order walk over the arrays.  Because the operands of a node
+ * were added just before it, the walk moves backwards through one
+ * short run of memory instead of chasing pointers around the heap.
+ */
+
+int ExpPool::eval(int node, EvalState &state) const {
+    switch (NodeOp(ops[node])) {
+        case CONST_NODE:
+            return constants[lhs[node]];
+        case VAR_NODE: {
+            const int slot = slots[lhs[node]];
+            if (!state.isDefined(slot)) error("VARIABLE NOT DEFINED");
+            return state.getValue(slot);
+        }
+        case ASSIGN_NODE: {
+            const int value = eval(rhs[node], state);
+            state.setValue(slots[lhs[node]], value);
+            return value;
+        }
+        case ILLEGAL_ASSIGN_NODE:
+            error("Illegal variable in assignment");
+            return 0;
+        case LET_ASSIGN_NODE:
+            error("SYNTAX ERROR");
+            return 0;
+        default:
+            break;
+    }
+    const int left = eval(lhs[node], state);
+    const int right = eval(rhs[node], state);
+    switch (NodeOp(ops[node])) {
+        case ADD_NODE:
+            return left + right;
+        case SUB_NODE:
+            return left - right;
+        case MUL_NODE:
+            return left * right;
+        case DIV_NODE:
+            if (right == 0) error("DIVIDE BY ZERO");
+            return left / right;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Implementation notes: truncate
+ * ------------------------------
+ * Leaves append to the side arrays in the same order as their nodes
+ * to the node arrays, so the constants and slots of the dropped nodes
+ * are the ones at the end of the side arrays.
+ */
+
+void ExpPool::truncate(int size) {
+    std::size_t constantCount = constants.size(), slotCount = slots.size();
+    for (std::size_t node = size; node < ops.size(); ++node) {
+        if (ops[node] == CONST_NODE) {
+            --constantCount;
+        } else if (ops[node] == VAR_NODE || ops[node] == ASSIGN_NODE) {
+            --slotCount;
+        }
+    }
+    ops.resize(size);
+    lhs.resize(size);
+    rhs.resize(size);
+    constants.resize(constantCount);
+    slots.resize(slotCount);
+}
+
+void ExpPool::clear() {
+    ops.clear();
+    lhs.clear();
+    rhs.clear();
+    constants.clear();
+    slots.clear();
+}
+
+std::size_t ExpPool::getBytes() const {
+    return ops.size() * (sizeof(uint8_t) + 2 * sizeof(uint32_t))
+           + (constants.size() + slots.size()) * sizeof(int);
+}
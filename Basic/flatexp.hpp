@@ -0,0 +1,123 @@
+/*
+ * File: flatexp.h
+ * ---------------
+ * This interface exports the ExpPool class, a flat representation of
+ * all the expressions of a program.  The interpreter stores its
+ * expressions there when it is started with --flat.
+ */
+
+#ifndef _flatexp_h
+#define _flatexp_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "exp.hpp"
+#include "evalstate.hpp"
+
+/*
+ * Type: NodeOp
+ * ------------
+ * The operation of a node in an ExpPool.  An assignment keeps the
+ * slot it assigns instead of a left operand; an assignment to
+ * something other than a variable, or to a variable named LET, is a
+ * node of its own that raises the error Expression::eval would.
+ */
+
+enum NodeOp : uint8_t {
+    CONST_NODE,          // constants[lhs]
+    VAR_NODE,            // the variable in slots[lhs]
+    ADD_NODE,
+    SUB_NODE,
+    MUL_NODE,
+    DIV_NODE,
+    OTHER_NODE,          // an operator without a meaning, yields 0
+    ASSIGN_NODE,         // slots[lhs] = rhs
+    ILLEGAL_ASSIGN_NODE, // Illegal variable in assignment
+    LET_ASSIGN_NODE      // SYNTAX ERROR
+};
+
+/*
+ * Class: ExpPool
+ * --------------
+ * Expression nodes stored as a structure of arrays instead of objects
+ * on the heap.  Node i has the operation ops[i] and the child indices
+ * lhs[i] and rhs[i]; constants and variable slots live in side arrays
+ * that leaf nodes index into.  The nodes of an expression are added
+ * in post order, so the children of a node sit just before it and an
+ * expression occupies one contiguous run of the arrays.  A statement
+ * refers to its expression by the index of the root node.
+ *
+ * Nodes are only ever appended.  truncate takes back the nodes of a
+ * command run in immediate mode and those of a replaced line that
+ * were the last ones added.  The nodes of other replaced lines are
+ * reclaimed by the program, which rebuilds the pool once they make up
+ * most of it (see Program::bindFlat).
+ */
+
+class ExpPool {
+
+public:
+
+/*
+ * Method: add
+ * Usage: int node = pool.add(exp);
+ * --------------------------------
+ * Appends the nodes of exp and returns the index of its root.  The
+ * pool does not refer to exp afterwards.
+ */
+
+    int add(Expression *exp);
+
+/*
+ * Method: eval
+ * Usage: int value = pool.eval(node, state);
+ * ------------------------------------------
+ * Evaluates the expression rooted at node in the context of state.
+ * Operands are evaluated left to right, so the errors are raised in
+ * the same order as by Expression::eval.
+ */
+
+    int eval(int node, EvalState &state) const;
+
+/*
+ * Methods: size, truncate, clear
+ * Usage: int mark = pool.size();
+ *        pool.truncate(mark);
+ *        pool.clear();
+ * -------------------------------
+ * size returns the number of nodes in the pool.  truncate drops the
+ * nodes added after the pool had size nodes, and clear drops them
+ * all.
+ */
+
+    int size() const {
+        return int(ops.size());
+    }
+
+    void truncate(int size);
+
+    void clear();
+
+/*
+ * Method: getBytes
+ * Usage: std::size_t bytes = pool.getBytes();
+ * -------------------------------------------
+ * Returns the number of bytes the nodes and side arrays take up.
+ */
+
+    std::size_t getBytes() const;
+
+private:
+
+    std::vector<uint8_t> ops;
+    std::vector<uint32_t> lhs;
+    std::vector<uint32_t> rhs;
+    std::vector<int> constants;
+    std::vector<int> slots;
+
+    int push(NodeOp op, uint32_t left, uint32_t right);
+
+};
+
+#endif
@@ -0,0 +1,487 @@
+/*
+ * File: jit.cpp
+ * -------------
+ * This file implements the native code generator declared in jit.h.
+ * Only x86-64 on systems with mmap is supported; elsewhere translate
+ * and run are never called, because supported returns false.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include "jit.hpp"
+#include "vm.hpp"
+#include "evalstate.hpp"
+#include "statement.hpp"
+#include "Utils/error.hpp"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define NATIVE_CODE 1
+#include <sys/mman.h>
+#else
+#define NATIVE_CODE 0
+#endif
+
+
+NativeCode::NativeCode() : buffer(nullptr), mapped(0), source(nullptr) {}
+
+NativeCode::~NativeCode() {
+    release();
+}
+
+bool NativeCode::supported() {
+    return NATIVE_CODE;
+}
+
+void NativeCode::release() {
+#if NATIVE_CODE
+    if (buffer != nullptr) {
+        munmap(buffer, mapped);
+    }
+#endif
+    buffer = nullptr;
+    mapped = 0;
+}
+
+int NativeCode::enterBlock(Bytecode *code, int index) {
+    return code->admit(index);
+}
+
+void NativeCode::print(int value) {
+    std::cout << value << std::endl;
+}
+
+int NativeCode::input() {
+    return InputStatement::readValue();
+}
+
+#if NATIVE_CODE
+
+/*
+ * Implementation notes: registers
+ * -------------------------------
+ * The generated code keeps its context in callee-saved registers, so
+ * calls to the C++ helpers need not save anything: rbx points to the
+ * frame of cells, r12 to the blocks of the bytecode, r13 to the
+ * Context and r14 to the top of the operand stack.  eax and ecx are
+ * scratch registers.
+ */
+
+enum Register {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R12 = 12, R13 = 13, R14 = 14
+};
+
+/* Condition codes, as in the low nibble of the Jcc opcodes */
+
+enum Condition {
+    CC_AE = 0x3, CC_E = 0x4, CC_L = 0xC, CC_G = 0xF
+};
+
+/*
+ * Class: Assembler
+ * ----------------
+ * Appends x86-64 instructions to a byte buffer.  Memory operands are
+ * always encoded as [base + disp32], which keeps the encoder to the
+ * handful of forms the templates need.
+ */
+
+class Assembler {
+
+public:
+
+    std::vector<unsigned char> bytes;
+
+    std::size_t size() const {
+        return bytes.size();
+    }
+
+    void byte(unsigned value) {
+        bytes.push_back((unsigned char) value);
+    }
+
+    void dword(int32_t value) {
+        unsigned char raw[4];
+        std::memcpy(raw, &value, 4);
+        bytes.insert(bytes.end(), raw, raw + 4);
+    }
+
+    void qword(uint64_t value) {
+        unsigned char raw[8];
+        std::memcpy(raw, &value, 8);
+        bytes.insert(bytes.end(), raw, raw + 8);
+    }
+
+/* Emits opcode with a reg, [base + disp] operand; wide selects 64 bits */
+
+    void mem(bool wide, std::initializer_list<unsigned> opcode, int reg, int base, int32_t disp) {
+        const unsigned rex = 0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (base & 8 ? 1 : 0);
+        if (rex != 0x40) {
+            byte(rex);
+        }
+        for (unsigned op : opcode) {
+            byte(op);
+        }
+        byte(0x80 | (reg & 7) << 3 | (base & 7));
+        if ((base & 7) == RSP) { // rsp 和 r12 作基址要带 SIB 字节
+            byte(0x24);
+        }
+        dword(disp);
+    }
+
+/* Emits a jump or conditional jump with a zero offset; returns where the offset goes */
+
+    std::size_t jump() {
+        byte(0xE9);
+        dword(0);
+        return size() - 4;
+    }
+
+    std::size_t jump(Condition cc) {
+        byte(0x0F);
+        byte(0x80 | cc);
+        dword(0);
+        return size() - 4;
+    }
+
+    void patch(std::size_t at, std::size_t target) {
+        const int32_t offset = int32_t(target) - int32_t(at + 4);
+        std::memcpy(&bytes[at], &offset, 4);
+    }
+
+    void call(const void *function) {
+        byte(0x48); // mov rax, imm64
+        byte(0xB8);
+        qword(uint64_t(function));
+        byte(0xFF); // call rax
+        byte(0xD0);
+    }
+
+    void push(int reg) {
+        mem(false, {0x89}, reg, R14, 0);
+        byte(0x49); // add r14, 4
+        byte(0x83);
+        byte(0xC6);
+        byte(4);
+    }
+
+    void pop(int reg) {
+        drop(4);
+        mem(false, {0x8B}, reg, R14, 0);
+    }
+
+    void drop(int size) {
+        byte(0x49); // sub r14, size
+        byte(0x83);
+        byte(0xEE);
+        byte(size);
+    }
+
+};
+
+/*
+ * Implementation notes: translate
+ * -------------------------------
+ * The bytecode is translated in a single pass from start to end.  The
+ * words of redirected fragments are translated too, although they are
+ * never reached; that is simpler than finding the live code and costs
+ * only space.  Every instruction start records its machine code offset
+ * so that jumps, which always target the entry of a fragment, can be
+ * patched at the end.  Rare paths (errors, the slow path of OP_BLOCK)
+ * jump to stubs placed after the main body, so the hot code falls
+ * straight through.
+ *
+ * An OP_BLOCK does the fast path of the VM inline: it compares the
+ * block's entries with its headroom and counts the pass.  Otherwise it
+ * calls Bytecode::admit, which activates the block on its first pass;
+ * if the pass would reach the execution limit the code exits and the
+ * VM resumes at the OP_BLOCK, which deals with the limit as usual.
+ */
+
+void NativeCode::translate(Bytecode &code) {
+    struct Exit {
+        std::size_t at;
+        Status status;
+        int pc;
+    };
+    struct Slow {
+        std::size_t at;
+        std::size_t back;
+        int index;
+        int pc;
+    };
+    Assembler a;
+    std::vector<std::pair<std::size_t, int>> jumps; // 待回填的跳转和目标字节码地址
+    std::vector<Exit> exits;
+    std::vector<Slow> slows;
+    const std::vector<Instruction> &words = code.code;
+    source = &code;
+    offsets.assign(words.size(), -1);
+
+    /* Entry: int native(Context *context, const void *start) */
+    a.byte(0x55); // push rbp
+    a.byte(0x53); // push rbx
+    a.byte(0x41); a.byte(0x54); // push r12
+    a.byte(0x41); a.byte(0x55); // push r13
+    a.byte(0x41); a.byte(0x56); // push r14，此时 rsp 按 16 字节对齐
+    a.byte(0x49); a.byte(0x89); a.byte(0xFD); // mov r13, rdi
+    a.mem(true, {0x8B}, RBX, R13, offsetof(Context, cells));
+    a.mem(true, {0x8B}, R12, R13, offsetof(Context, blocks));
+    a.mem(true, {0x8B}, R14, R13, offsetof(Context, stack));
+    a.byte(0xFF); a.byte(0xE6); // jmp rsi
+
+    const std::size_t epilogue = a.size(); // eax 里是退出状态
+    a.byte(0x41); a.byte(0x5E); // pop r14
+    a.byte(0x41); a.byte(0x5D); // pop r13
+    a.byte(0x41); a.byte(0x5C); // pop r12
+    a.byte(0x5B); // pop rbx
+    a.byte(0x5D); // pop rbp
+    a.byte(0xC3); // ret
+
+    auto leave = [&](Status status, int pc) {
+        a.mem(false, {0xC7}, 0, R13, offsetof(Context, exitPc));
+        a.dword(pc);
+        a.byte(0xB8); // mov eax, status
+        a.dword(status);
+        a.patch(a.jump(), epilogue);
+    };
+    auto load = [&](int reg, int slot, int pc) { // 带 VARIABLE NOT DEFINED 检查
+        a.mem(false, {0x83}, 7, RBX, 8 * slot + 4); // cmp dword [cell + 4], 0
+        a.byte(0);
+        exits.push_back({a.jump(CC_E), EXIT_UNDEFINED, pc});
+        a.mem(false, {0x8B}, reg, RBX, 8 * slot);
+    };
+    auto store = [&](int reg, int slot) {
+        a.mem(false, {0x89}, reg, RBX, 8 * slot);
+        a.mem(false, {0xC7}, 0, RBX, 8 * slot + 4);
+        a.dword(1);
+    };
+    auto divide = [&](int pc) { // eax = eax / ecx
+        a.byte(0x85); a.byte(0xC9); // test ecx, ecx
+        exits.push_back({a.jump(CC_E), EXIT_DIVIDE, pc});
+        a.byte(0x99); // cdq
+        a.byte(0xF7); a.byte(0xF9); // idiv ecx
+    };
+
+    for (std::size_t pc = 0; pc < words.size(); ++pc) {
+        const Instruction &in = words[pc];
+        const int at = int(pc);
+        offsets[pc] = int(a.size());
+        switch (in.op) {
+            case OP_HALT:
+                leave(EXIT_HALT, at);
+                break;
+            case OP_BLOCK: {
+                const std::size_t block = std::size_t(in.operand) * sizeof(Bytecode::Block);
+                const int32_t entries = int32_t(block + offsetof(Bytecode::Block, entries));
+                const int32_t headroom = int32_t(block + offsetof(Bytecode::Block, headroom));
+                a.mem(false, {0xC7}, 0, R13, offsetof(Context, current));
+                a.dword(in.operand);
+                a.mem(true, {0x8B}, RAX, R12, entries);
+                a.mem(true, {0x3B}, RAX, R12, headroom);
+                const std::size_t slow = a.jump(CC_AE);
+                a.mem(true, {0xFF}, 0, R12, entries); // inc qword [entries]
+                slows.push_back({slow, a.size(), in.operand, at});
+                break;
+            }
+            case OP_CONST:
+                a.mem(false, {0xC7}, 0, R14, 0);
+                a.dword(in.operand);
+                a.byte(0x49); a.byte(0x83); a.byte(0xC6); a.byte(4); // add r14, 4
+                break;
+            case OP_LOAD:
+                load(RAX, in.operand, at);
+                a.push(RAX);
+                break;
+            case OP_STORE:
+                a.pop(RAX);
+                store(RAX, in.operand);
+                break;
+            case OP_ASSIGN:
+                a.mem(false, {0x8B}, RAX, R14, -4);
+                store(RAX, in.operand);
+                break;
+            case OP_ADD:
+                a.pop(RAX);
+                a.mem(false, {0x01}, RAX, R14, -4);
+                break;
+            case OP_SUB:
+                a.pop(RAX);
+                a.mem(false, {0x29}, RAX, R14, -4);
+                break;
+            case OP_MUL:
+                a.pop(RCX);
+                a.mem(false, {0x8B}, RAX, R14, -4);
+                a.byte(0x0F); a.byte(0xAF); a.byte(0xC1); // imul eax, ecx
+                a.mem(false, {0x89}, RAX, R14, -4);
+                break;
+            case OP_DIV:
+                a.pop(RCX);
+                a.mem(false, {0x8B}, RAX, R14, -4);
+                divide(at);
+                a.mem(false, {0x89}, RAX, R14, -4);
+                break;
+            case OP_DROP2_ZERO:
+                a.drop(4);
+                a.mem(false, {0xC7}, 0, R14, -4);
+                a.dword(0);
+                break;
+            case OP_PRINT:
+                a.pop(RDI);
+                a.call((const void *) &NativeCode::print);
+                break;
+            case OP_INPUT:
+                a.call((const void *) &NativeCode::input);
+                store(RAX, in.operand);
+                break;
+            case OP_JUMP:
+                jumps.emplace_back(a.jump(), in.operand);
+                break;
+            case OP_JUMP_EQ:
+            case OP_JUMP_LT:
+            case OP_JUMP_GT:
+                a.drop(8);
+                a.mem(false, {0x8B}, RAX, R14, 0);
+                a.mem(false, {0x3B}, RAX, R14, 4); // cmp eax, [r14 + 4]
+                jumps.emplace_back(a.jump(in.op == OP_JUMP_EQ ? CC_E : in.op == OP_JUMP_LT ? CC_L : CC_G), in.operand);
+                break;
+            case OP_MISSING_LINE:
+                leave(EXIT_MISSING_LINE, at);
+                break;
+            case OP_FAIL:
+                leave(EXIT_FAIL, at);
+                break;
+            case OP_TRAP:
+                leave(EXIT_RESUME, at);
+                break;
+            case OP_SET_CONST:
+                a.mem(false, {0xC7}, 0, RBX, 8 * in.operand);
+                a.dword(words[pc + 1].operand);
+                a.mem(false, {0xC7}, 0, RBX, 8 * in.operand + 4);
+                a.dword(1);
+                pc += 1;
+                break;
+            case OP_COPY:
+                load(RAX, words[pc + 1].operand, at);
+                store(RAX, in.operand);
+                pc += 1;
+                break;
+            case OP_ADD_CONST:
+                load(RAX, words[pc + 1].operand, at);
+                a.byte(0x05); // add eax, imm32
+                a.dword(words[pc + 2].operand);
+                store(RAX, in.operand);
+                pc += 2;
+                break;
+            case OP_SET_ADD:
+            case OP_SET_SUB:
+            case OP_SET_MUL:
+            case OP_SET_DIV:
+                load(RAX, words[pc + 1].operand, at);
+                load(RCX, words[pc + 2].operand, at);
+                if (in.op == OP_SET_ADD) {
+                    a.byte(0x01); a.byte(0xC8); // add eax, ecx
+                } else if (in.op == OP_SET_SUB) {
+                    a.byte(0x29); a.byte(0xC8); // sub eax, ecx
+                } else if (in.op == OP_SET_MUL) {
+                    a.byte(0x0F); a.byte(0xAF); a.byte(0xC1); // imul eax, ecx
+                } else {
+                    divide(at);
+                }
+                store(RAX, in.operand);
+                pc += 2;
+                break;
+            case OP_JUMP_EQ_CONST:
+            case OP_JUMP_LT_CONST:
+            case OP_JUMP_GT_CONST:
+                load(RAX, in.operand, at);
+                a.byte(0x3D); // cmp eax, imm32
+                a.dword(words[pc + 1].operand);
+                jumps.emplace_back(a.jump(in.op == OP_JUMP_EQ_CONST ? CC_E : in.op == OP_JUMP_LT_CONST ? CC_L : CC_G),
+                                   words[pc + 2].operand);
+                pc += 2;
+                break;
+        }
+    }
+
+    for (const Slow &slow : slows) { // OP_BLOCK 的慢路径
+        a.patch(slow.at, a.size());
+        a.mem(true, {0x8B}, RDI, R13, offsetof(Context, code));
+        a.byte(0xBE); // mov esi, index
+        a.dword(slow.index);
+        a.call((const void *) &NativeCode::enterBlock);
+        a.byte(0x85); a.byte(0xC0); // test eax, eax
+        exits.push_back({a.jump(CC_E), EXIT_RESUME, slow.pc});
+        a.patch(a.jump(), slow.back);
+    }
+    for (const Exit &exit : exits) {
+        a.patch(exit.at, a.size());
+        leave(exit.status, exit.pc);
+    }
+    for (const auto &jump : jumps) {
+        a.patch(jump.first, offsets[jump.second]);
+    }
+
+    release();
+    const std::size_t page = 4096;
+    mapped = (a.size() + page - 1) / page * page;
+    void *memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        mapped = 0;
+        error("JIT: cannot map memory for native code");
+    }
+    buffer = static_cast<unsigned char *>(memory);
+    std::memcpy(buffer, a.bytes.data(), a.size());
+    if (mprotect(buffer, mapped, PROT_READ | PROT_EXEC) != 0) { // 写完再改成可执行，不同时可写可执行
+        release(); // 强制 W^X 的环境里可能改不了，不能跳进去
+        error("JIT: cannot make native code executable");
+    }
+}
+
+/*
+ * Implementation notes: run
+ * -------------------------
+ * The frame is filled from the state on every call and written back
+ * on every exit, whatever the status, so the runtime and the virtual
+ * machine always see the variables the native code has assigned.
+ * Slots never become undefined during a RUN, so only defined cells
+ * need to be written back.
+ */
+
+NativeCode::Status NativeCode::run(int &pc, EvalState &state, int &current) {
+    const int slots = EvalState::slotCount();
+    cells.assign(slots, {0, 0});
+    for (int slot = 0; slot < slots; ++slot) {
+        if (state.isDefined(slot)) {
+            cells[slot] = {state.getValue(slot), 1};
+        }
+    }
+    stack.resize(source->maxDepth + 1);
+    Context context = {cells.data(), source->blocks.data(), stack.data(), source, -1, pc};
+    auto entry = reinterpret_cast<int (*)(Context *, const void *)>(buffer);
+    const auto status = Status(entry(&context, buffer + offsets[pc]));
+    for (int slot = 0; slot < slots; ++slot) {
+        if (cells[slot].defined) {
+            state.setValue(slot, cells[slot].value);
+        }
+    }
+    pc = context.exitPc;
+    current = context.current;
+    return status;
+}
+
+#else
+
+void NativeCode::translate(Bytecode &code) {
+    source = &code;
+    error("JIT: native code is not supported on this platform");
+}
+
+NativeCode::Status NativeCode::run(int &pc, EvalState &state, int &current) {
+    current = -1;
+    return EXIT_RESUME;
+}
+
+#endif
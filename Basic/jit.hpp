@@ -0,0 +1,140 @@
+/*
+ * File: jit.h
+ * -----------
+ * This interface exports the native code generator used by RUN when
+ * the interpreter is started with --jit.  It translates the bytecode
+ * of a program into x86-64 machine code, one template per instruction,
+ * and runs it until the program ends or control has to go back to the
+ * virtual machine.
+ */
+
+#ifndef _jit_h
+#define _jit_h
+
+#include <cstddef>
+#include <vector>
+
+class Bytecode;
+class EvalState;
+
+/*
+ * Class: NativeCode
+ * -----------------
+ * The machine code for one version of a program's bytecode.  Variables
+ * live in a frame array of cells, one per slot, that holds the value
+ * and whether it is defined; the frame is copied in from the EvalState
+ * on entry and back out on every exit.  GOTO and IF are native jumps.
+ * The operand stack stays in memory, addressed through a register.
+ *
+ * The native code never raises an error itself.  Whatever needs the
+ * runtime (an error, a missing line, a pass that reaches the execution
+ * limit) leaves the native code with an exit status and the bytecode
+ * address where it happened, and Bytecode::run takes it from there.
+ */
+
+class NativeCode {
+
+public:
+
+/*
+ * Type: Status
+ * ------------
+ * Why the native code returned.  EXIT_RESUME asks the virtual machine
+ * to carry on from the bytecode address of the exit.
+ */
+
+    enum Status {
+        EXIT_HALT,
+        EXIT_MISSING_LINE,
+        EXIT_UNDEFINED,
+        EXIT_DIVIDE,
+        EXIT_FAIL,
+        EXIT_RESUME
+    };
+
+    NativeCode();
+    ~NativeCode();
+
+    NativeCode(const NativeCode &) = delete;
+    NativeCode &operator=(const NativeCode &) = delete;
+
+/*
+ * Static method: supported
+ * Usage: if (NativeCode::supported()) ...
+ * ---------------------------------------
+ * Returns true if this build can generate and run native code, which
+ * needs an x86-64 processor and mmap.
+ */
+
+    static bool supported();
+
+/*
+ * Method: translate
+ * Usage: native.translate(code);
+ * ------------------------------
+ * Discards the previous machine code and translates the current
+ * bytecode, which must have been finished.  Raises an error if the
+ * system refuses memory for the code or refuses to make it
+ * executable; no machine code is left behind then.
+ */
+
+    void translate(Bytecode &code);
+
+/*
+ * Method: run
+ * Usage: Status status = native.run(pc, state, current);
+ * ------------------------------------------------------
+ * Runs the machine code from the bytecode address pc, which must be
+ * the entry of a fragment.  On return pc is the bytecode address of
+ * the exit and current the basic block that was being executed, or
+ * -1 if none was.  The variables in state are brought up to date
+ * before run returns.
+ */
+
+    Status run(int &pc, EvalState &state, int &current);
+
+private:
+
+/*
+ * Type: Cell
+ * ----------
+ * One variable in the frame.  The native code reads the value at
+ * offset 0 and tests the flag at offset 4.
+ */
+
+    struct Cell {
+        int value;
+        int defined;
+    };
+
+/*
+ * Type: Context
+ * -------------
+ * Everything the native code needs, passed to it in a register and
+ * addressed by fixed offsets.
+ */
+
+    struct Context {
+        Cell *cells;
+        void *blocks;
+        int *stack;
+        Bytecode *code;
+        int current;
+        int exitPc;
+    };
+
+    unsigned char *buffer; // 可执行的内存，按页 mmap
+    std::size_t mapped;
+    std::vector<int> offsets; // 字节码地址 -> 机器码偏移，不是指令开头的为 -1
+    std::vector<Cell> cells;
+    std::vector<int> stack;
+    Bytecode *source;
+
+    void release();
+    static int enterBlock(Bytecode *code, int index);
+    static void print(int value);
+    static int input();
+
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * File: keyword.h
+ * ---------------
+ * This interface exports the keywords of BASIC and a function that
+ * recognizes them.  The statement parser, the command dispatcher and
+ * the check for reserved variable names (isReservedName) all go
+ * through keywordOf.
+ */
+
+#ifndef _keyword_h
+#define _keyword_h
+
+#include <string_view>
+
+/*
+ * Type: Keyword
+ * -------------
+ * The keywords of BASIC: the statements, the commands and THEN.
+ * NOT_KEYWORD stands for any other word.
+ */
+
+enum Keyword : unsigned char {
+    NOT_KEYWORD,
+    REM_KEYWORD, LET_KEYWORD, PRINT_KEYWORD, INPUT_KEYWORD, END_KEYWORD, GOTO_KEYWORD, IF_KEYWORD, THEN_KEYWORD,
+    RUN_KEYWORD, LIST_KEYWORD, CLEAR_KEYWORD, QUIT_KEYWORD, HELP_KEYWORD, LOAD_KEYWORD
+};
+
+/*
+ * Function: keywordOf
+ * Usage: Keyword keyword = keywordOf(word);
+ * -----------------------------------------
+ * Returns the keyword spelled by word, which must match exactly, or
+ * NOT_KEYWORD.  The function is constexpr so that the compile-time
+ * parser of embed.h can use it as well.
+ *
+ * The length and the first letter pick at most one candidate, so a
+ * word is compared against a single keyword.  Adding a keyword means
+ * adding a case here, not making a chain of comparisons longer.
+ */
+
+constexpr Keyword keywordOf(std::string_view word) {
+    Keyword candidate = NOT_KEYWORD;
+    std::string_view spelling;
+    switch (word.size()) {
+        case 2:
+            candidate = IF_KEYWORD, spelling = "IF";
+            break;
+        case 3:
+            switch (word[0]) {
+                case 'R':
+                    if (word[1] == 'E') candidate = REM_KEYWORD, spelling = "REM";
+                    else candidate = RUN_KEYWORD, spelling = "RUN";
+                    break;
+                case 'L':
+                    candidate = LET_KEYWORD, spelling = "LET";
+                    break;
+                case 'E':
+                    candidate = END_KEYWORD, spelling = "END";
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case 4:
+            switch (word[0]) {
+                case 'G':
+                    candidate = GOTO_KEYWORD, spelling = "GOTO";
+                    break;
+                case 'T':
+                    candidate = THEN_KEYWORD, spelling = "THEN";
+                    break;
+                case 'L':
+                    if (word[1] == 'I') candidate = LIST_KEYWORD, spelling = "LIST";
+                    else candidate = LOAD_KEYWORD, spelling = "LOAD";
+                    break;
+                case 'Q':
+                    candidate = QUIT_KEYWORD, spelling = "QUIT";
+                    break;
+                case 'H':
+                    candidate = HELP_KEYWORD, spelling = "HELP";
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case 5:
+            switch (word[0]) {
+                case 'P':
+                    candidate = PRINT_KEYWORD, spelling = "PRINT";
+                    break;
+                case 'I':
+                    candidate = INPUT_KEYWORD, spelling = "INPUT";
+                    break;
+                case 'C':
+                    candidate = CLEAR_KEYWORD, spelling = "CLEAR";
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+    return candidate != NOT_KEYWORD && word == spelling ? candidate : NOT_KEYWORD;
+}
+
+/*
+ * Function: isReservedName
+ * Usage: if (isReservedName(word)) ...
+ * ------------------------------------
+ * Returns true if word cannot be used as a variable name.  LOAD was
+ * added as a command later and is not reserved, so that programs that
+ * already use it as a variable keep working.
+ */
+
+constexpr bool isReservedName(std::string_view word) {
+    const Keyword keyword = keywordOf(word);
+    return keyword != NOT_KEYWORD && keyword != LOAD_KEYWORD;
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * File: lexer.cpp
+ * ---------------
+ * This file implements the Lexer class declared in lexer.h.
+ */
+
+#include <cctype>
+#include <climits>
+#include "lexer.hpp"
+
+
+/*
+ * Implementation notes: character classes
+ * ---------------------------------------
+ * These follow TokenScanner, which uses the <cctype> functions with
+ * the default locale.
+ */
+
+static inline bool isSpace(char ch) {
+    return isspace((unsigned char) ch);
+}
+
+static inline bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+static inline bool isWordCharacter(char ch) {
+    return isalnum((unsigned char) ch);
+}
+
+static inline TokenKind operatorKind(char ch) {
+    switch (ch) {
+        case '+': return PLUS_TOKEN;
+        case '-': return MINUS_TOKEN;
+        case '*': return STAR_TOKEN;
+        case '/': return SLASH_TOKEN;
+        case '=': return EQUALS_TOKEN;
+        case '<': return LESS_TOKEN;
+        case '>': return GREATER_TOKEN;
+        case '(': return LEFT_PAREN_TOKEN;
+        case ')': return RIGHT_PAREN_TOKEN;
+        default: return OPERATOR_TOKEN;
+    }
+}
+
+Lexer::Lexer(std::string_view line) : line(line), pos(0), buffered(0) {}
+
+Token Lexer::next() {
+    if (buffered == 0) {
+        return scan();
+    }
+    const Token token = buffer[0];
+    for (int i = 1; i < buffered; ++i) {
+        buffer[i - 1] = buffer[i];
+    }
+    --buffered;
+    return token;
+}
+
+Token Lexer::peek(int ahead) {
+    while (buffered <= ahead) {
+        buffer[buffered++] = scan();
+    }
+    return buffer[ahead];
+}
+
+std::string_view Lexer::getRemainingInput() {
+    const std::size_t start = buffered > 0 ? buffer[0].text.data() - line.data() : pos;
+    buffered = 0;
+    pos = line.size();
+    std::string_view rest = line.substr(start);
+    while (!rest.empty() && isSpace(rest.front())) rest.remove_prefix(1);
+    while (!rest.empty() && isSpace(rest.back())) rest.remove_suffix(1);
+    return rest;
+}
+
+/*
+ * Implementation notes: toInteger
+ * -------------------------------
+ * This accepts what stringToInteger accepts from a number token:
+ * decimal digits, leading zeros included, with a value that fits in
+ * an int.
+ */
+
+bool Lexer::toInteger(const Token &token, int &value) {
+    if (token.kind != NUMBER_TOKEN) {
+        return false;
+    }
+    long long result = 0;
+    for (char ch : token.text) {
+        if (!isDigit(ch)) return false;
+        result = result * 10 + (ch - '0');
+        if (result > INT_MAX) return false;
+    }
+    value = int(result);
+    return true;
+}
+
+/*
+ * Implementation notes: scan
+ * --------------------------
+ * This is TokenScanner::nextToken with no comments, strings or
+ * multi-character operators, which the interpreter never turns on.
+ * An exponent marker only belongs to a number if digits follow it,
+ * possibly after a sign.  When none do, TokenScanner backs up to the
+ * marker but still returns it, and its sign, as part of the number:
+ * "1e" is the token 1e followed by the token e.  The lexer does the
+ * same, and toInteger rejects such a number.
+ */
+
+Token Lexer::scan() {
+    while (pos < line.size() && isSpace(line[pos])) ++pos;
+    const std::size_t start = pos;
+    if (pos == line.size()) {
+        return {END_TOKEN, line.substr(start, 0)};
+    }
+    TokenKind kind;
+    if (isDigit(line[pos])) {
+        kind = NUMBER_TOKEN;
+        while (pos < line.size() && isDigit(line[pos])) ++pos;
+        if (pos < line.size() && line[pos] == '.') {
+            ++pos;
+            while (pos < line.size() && isDigit(line[pos])) ++pos;
+        }
+        if (pos < line.size() && (line[pos] == 'e' || line[pos] == 'E')) {
+            std::size_t exponent = pos + 1;
+            if (exponent < line.size() && (line[exponent] == '+' || line[exponent] == '-')) ++exponent;
+            if (exponent < line.size() && isDigit(line[exponent])) {
+                pos = exponent;
+                while (pos < line.size() && isDigit(line[pos])) ++pos;
+            } else {
+                return {NUMBER_TOKEN, line.substr(start, exponent - start)}; // 见上面的说明
+            }
+        }
+    } else if (isWordCharacter(line[pos])) {
+        kind = WORD_TOKEN;
+        while (pos < line.size() && isWordCharacter(line[pos])) ++pos;
+    } else {
+        kind = operatorKind(line[pos]);
+        ++pos;
+    }
+    return {kind, line.substr(start, pos - start)};
+}
@@ -0,0 +1,154 @@
+/*
+ * File: lexer.h
+ * -------------
+ * This interface exports the Lexer class, which splits a line of
+ * BASIC into tokens for the parser without copying it.
+ */
+
+#ifndef _lexer_h
+#define _lexer_h
+
+#include <cstddef>
+#include <string_view>
+
+/*
+ * Type: TokenKind
+ * ---------------
+ * The kind of a token.  The characters the parser knows as operators
+ * or brackets each have a kind of their own, so the parser can switch
+ * on the kind instead of comparing text; any other character is an
+ * OPERATOR_TOKEN.  END_TOKEN is returned, with empty text, once the
+ * line has been used up.
+ */
+
+enum TokenKind : unsigned char {
+    END_TOKEN, NUMBER_TOKEN, WORD_TOKEN, OPERATOR_TOKEN,
+    PLUS_TOKEN, MINUS_TOKEN, STAR_TOKEN, SLASH_TOKEN,
+    EQUALS_TOKEN, LESS_TOKEN, GREATER_TOKEN,
+    LEFT_PAREN_TOKEN, RIGHT_PAREN_TOKEN,
+    TOKEN_KIND_COUNT
+};
+
+/*
+ * Type: Token
+ * -----------
+ * A token: its kind and its text, which points into the line being
+ * scanned and is only valid as long as the line is.
+ */
+
+struct Token {
+    TokenKind kind;
+    std::string_view text;
+};
+
+/*
+ * Class: Lexer
+ * ------------
+ * Scans a line the way a TokenScanner set to ignoreWhitespace and
+ * scanNumbers does, and produces the same tokens, but reads the line
+ * through a string_view and hands tokens out as views into it, so
+ * scanning never allocates.  Instead of a list of saved tokens, the
+ * lexer has a small fixed buffer for looking ahead.
+ *
+ * A number may run on into a fraction and an exponent (1.5, 2E3), as
+ * it does for TokenScanner; toInteger rejects those.  Like TokenScanner,
+ * the lexer scans an exponent marker with no digits after it both as
+ * the end of the number and as the start of the next token.
+ */
+
+class Lexer {
+
+public:
+
+/*
+ * Constructor: Lexer
+ * Usage: Lexer lexer(line);
+ * -------------------------
+ * Creates a lexer for the characters of line, which must outlive it.
+ */
+
+    explicit Lexer(std::string_view line);
+
+/*
+ * Method: next
+ * Usage: Token token = lexer.next();
+ * ----------------------------------
+ * Returns the next token and moves past it.
+ */
+
+    Token next();
+
+/*
+ * Method: peek
+ * Usage: Token token = lexer.peek(ahead);
+ * ---------------------------------------
+ * Returns the token that next would return after skipping ahead
+ * tokens, without moving.  ahead must be less than LOOKAHEAD.
+ */
+
+    Token peek(int ahead = 0);
+
+/*
+ * Method: hasMoreTokens
+ * Usage: if (lexer.hasMoreTokens()) ...
+ * -------------------------------------
+ * Returns true if there are tokens left on the line.
+ */
+
+    bool hasMoreTokens() {
+        return peek().kind != END_TOKEN;
+    }
+
+/*
+ * Method: offsetOf
+ * Usage: std::size_t offset = lexer.offsetOf(token);
+ * --------------------------------------------------
+ * Returns the position of token in the line, counted in characters
+ * from the start.  The end token is at the end of the line.
+ */
+
+    std::size_t offsetOf(const Token &token) const {
+        return token.text.data() - line.data();
+    }
+
+/*
+ * Method: getRemainingInput
+ * Usage: std::string_view rest = lexer.getRemainingInput();
+ * ---------------------------------------------------------
+ * Returns the rest of the line from the next token on, and moves to
+ * the end of the line.
+ */
+
+    std::string_view getRemainingInput();
+
+/*
+ * Static method: toInteger
+ * Usage: if (Lexer::toInteger(token, value)) ...
+ * ----------------------------------------------
+ * Converts a number token to an int and stores it in value.  Returns
+ * false, without raising an error, if the token is not a number or
+ * its text is not an integer that fits in an int.
+ */
+
+    static bool toInteger(const Token &token, int &value);
+
+/*
+ * Constant: LOOKAHEAD
+ * -------------------
+ * The number of tokens the lexer can look ahead.
+ */
+
+    static const int LOOKAHEAD = 2;
+
+private:
+
+    std::string_view line;
+    std::size_t pos; // 下一个还没扫描的字符
+    Token buffer[LOOKAHEAD]; // 看过但还没取走的 token
+    int buffered;
+
+    Token scan();
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * File: mapping.cpp
+ * -----------------
+ * This file implements the MappedFile class declared in mapping.h.
+ */
+
+#include <fstream>
+#include <iterator>
+#include "mapping.hpp"
+#include "Utils/error.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MAPPED_FILES 0
+#endif
+
+
+/*
+ * Implementation notes: readFile
+ * ------------------------------
+ * Reads the whole file into copy, for files that are not mapped.
+ */
+
+static void readFile(const std::string &path, std::string &copy) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error("FILE NOT FOUND");
+    }
+    copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+#if MAPPED_FILES
+
+/*
+ * Implementation notes: MappedFile
+ * --------------------------------
+ * The mapping is private and read-only.  The descriptor stays open so
+ * that isIntact can look at the file the text came from even if
+ * another file has taken its name since.  The kernel is told the
+ * file will be read from front to back, which is how a load walks it.
+ */
+
+static long long modificationTime(const struct stat &info) {
+#if defined(__APPLE__)
+    return info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    return info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+}
+
+MappedFile::MappedFile(const std::string &path) : data(""), size(0), fd(-1), modified(0) {
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        error("FILE NOT FOUND");
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        close(file);
+        error("FILE NOT FOUND");
+    }
+    if (std::size_t(info.st_size) < MAP_THRESHOLD) { // 小文件直接读进来
+        close(file);
+        readFile(path, copy);
+        data = copy.data();
+        size = copy.size();
+        return;
+    }
+    void *memory = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (memory == MAP_FAILED) {
+        close(file);
+        error("FILE NOT FOUND");
+    }
+    madvise(memory, std::size_t(info.st_size), MADV_SEQUENTIAL);
+    data = static_cast<const char *>(memory);
+    size = std::size_t(info.st_size);
+    fd = file;
+    modified = modificationTime(info);
+}
+
+MappedFile::~MappedFile() {
+    if (fd >= 0) {
+        munmap(const_cast<char *>(data), size);
+        close(fd);
+    }
+}
+
+bool MappedFile::isIntact() const {
+    if (fd < 0) {
+        return true;
+    }
+    struct stat info;
+    return fstat(fd, &info) == 0 && std::size_t(info.st_size) == size && modificationTime(info) == modified;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) : data(""), size(0), fd(-1), modified(0) {
+    readFile(path, copy);
+    data = copy.data();
+    size = copy.size();
+}
+
+MappedFile::~MappedFile() {}
+
+bool MappedFile::isIntact() const {
+    return true;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * File: mapping.h
+ * ---------------
+ * This interface exports the MappedFile class, which makes the text
+ * of a file available in memory without copying it.
+ */
+
+#ifndef _mapping_h
+#define _mapping_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Class: MappedFile
+ * -----------------
+ * The contents of a file, mapped read-only into memory.  The text is
+ * paged in from the file as it is read and stays backed by the file,
+ * so it costs no heap and no copy, and views into it stay valid for
+ * as long as the MappedFile lives.  Files smaller than MAP_THRESHOLD,
+ * and every file where mmap is not available, are read into a string
+ * instead, which the MappedFile owns.
+ *
+ * A mapped file must not be changed while it is mapped.  If it is
+ * rewritten, the text changes under the views; if it is truncated,
+ * reading past the new end kills the process with SIGBUS.  isIntact
+ * tells whether the file still has the size and modification time it
+ * had when it was mapped, so a client can check before it reads.
+ */
+
+class MappedFile {
+
+public:
+
+/*
+ * Constructor: MappedFile
+ * Usage: MappedFile file(path);
+ * -----------------------------
+ * Maps the file at path.  Raises the error FILE NOT FOUND if the file
+ * cannot be opened or mapped.
+ */
+
+    explicit MappedFile(const std::string &path);
+
+/*
+ * Destructor: ~MappedFile
+ * Usage: usually implicit
+ * -----------------------
+ * Unmaps the file.
+ */
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+/*
+ * Method: isIntact
+ * Usage: if (file.isIntact()) ...
+ * -------------------------------
+ * Returns false if the file was mapped and has since been changed, so
+ * that its text can no longer be read safely.  A file that was read
+ * into a string is always intact.
+ */
+
+    bool isIntact() const;
+
+/*
+ * Constant: MAP_THRESHOLD
+ * -----------------------
+ * Files of at least this many bytes are mapped; smaller ones are
+ * read, where a copy costs little and cannot go stale.
+ */
+
+    static const std::size_t MAP_THRESHOLD = 16 * 1024 * 1024;
+
+/*
+ * Method: getText
+ * Usage: std::string_view text = file.getText();
+ * ----------------------------------------------
+ * Returns the contents of the file.
+ */
+
+    std::string_view getText() const {
+        return std::string_view(data, size);
+    }
+
+private:
+
+    const char *data;
+    std::size_t size;
+    std::string copy; // 小文件或没有 mmap 时读进来的内容
+    int fd; // 映射的文件，用来检查有没有被改过；没映射时为 -1
+    long long modified; // 映射时文件的修改时间，纳秒
+
+};
+
+#endif
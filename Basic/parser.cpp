@@ -4,84 +4,278 @@
  * Implements the parser.h interface.
  */
 
+#include <array>
+#include <climits>
 #include "parser.hpp"
 
 
+/*
+ * Implementation notes: the operator tables
+ * -----------------------------------------
+ * The parser is a Pratt parser driven by two tables indexed by token
+ * kind, both built at compile time.  PREFIX says how a term that
+ * starts with a token of that kind is read; a kind without an entry
+ * cannot start a term.  INFIX gives the binding power, associativity
+ * and node constructor of each binary operator; a kind with power 0
+ * ends the expression.  Adding an operator such as ^ or MOD, or unary
+ * plus, takes a token kind and an entry in one of these tables.
+ */
+
+typedef ParseResult (*PrefixRule)(Lexer &lexer, const Token &token, int floor);
+
+struct InfixRule {
+    int power; // 0 表示不是二元运算符
+    bool rightAssociative;
+    Expression *(*make)(Expression *lhs, Expression *rhs);
+};
+
+static ParseResult success(Expression *exp) {
+    return {exp, PARSE_OK, 0};
+}
+
+static ParseResult failure(ParseError error, const Lexer &lexer, const Token &token) {
+    return {nullptr, error, lexer.offsetOf(token)};
+}
+
+template <char op>
+static Expression *makeCompound(Expression *lhs, Expression *rhs) {
+    return new CompoundExp(std::string(1, op), lhs, rhs);
+}
+
+static ParseResult readExpression(Lexer &lexer, int prec, int floor);
+static ParseResult readTerm(Lexer &lexer, int floor);
+
+static ParseResult readNumber(Lexer &lexer, const Token &token, int floor) {
+    int value;
+    if (!Lexer::toInteger(token, value)) {
+        return failure(ILLEGAL_INTEGER, lexer, token);
+    }
+    return success(new ConstantExp(value));
+}
+
+static ParseResult readIdentifier(Lexer &lexer, const Token &token, int floor) {
+    return success(new IdentifierExp(std::string(token.text)));
+}
+
+/*
+ * Implementation notes: readNegation
+ * ----------------------------------
+ * A minus sign negates the whole rest of the expression, not just the
+ * next term, so -2 + 3 is -(2 + 3).  That is how the interpreter has
+ * always read it.  The rest of the expression ends where the
+ * expression the minus sign is part of ends: at the floor the caller
+ * of readE set, so that in a condition -x = 3 negates x and leaves
+ * the = to readCondition.
+ */
+
+static ParseResult readNegation(Lexer &lexer, const Token &token, int floor) {
+    const ParseResult operand = readExpression(lexer, floor, floor);
+    if (!operand.ok()) {
+        return operand;
+    }
+    return success(new CompoundExp("-", new ConstantExp(0), operand.exp));
+}
+
+static ParseResult readGroup(Lexer &lexer, const Token &token, int floor) {
+    const ParseResult inner = readE(lexer); // 括号里从头算起
+    if (!inner.ok()) {
+        return inner;
+    }
+    const Token close = lexer.next();
+    if (close.kind != RIGHT_PAREN_TOKEN) {
+        return failure(UNBALANCED_PARENTHESES, lexer, close);
+    }
+    return inner;
+}
+
+static constexpr std::array<PrefixRule, TOKEN_KIND_COUNT> prefixTable() {
+    std::array<PrefixRule, TOKEN_KIND_COUNT> table = {};
+    table[NUMBER_TOKEN] = readNumber;
+    table[WORD_TOKEN] = readIdentifier;
+    table[MINUS_TOKEN] = readNegation;
+    table[LEFT_PAREN_TOKEN] = readGroup;
+    return table;
+}
+
+static constexpr std::array<InfixRule, TOKEN_KIND_COUNT> infixTable() {
+    std::array<InfixRule, TOKEN_KIND_COUNT> table = {};
+    table[EQUALS_TOKEN] = {1, false, makeCompound<'='>};
+    table[PLUS_TOKEN] = {2, false, makeCompound<'+'>};
+    table[MINUS_TOKEN] = {2, false, makeCompound<'-'>};
+    table[STAR_TOKEN] = {3, false, makeCompound<'*'>};
+    table[SLASH_TOKEN] = {3, false, makeCompound<'/'>};
+    return table;
+}
+
+static constexpr std::array<PrefixRule, TOKEN_KIND_COUNT> PREFIX = prefixTable();
+static constexpr std::array<InfixRule, TOKEN_KIND_COUNT> INFIX = infixTable();
+
+static_assert(INFIX[EQUALS_TOKEN].power == RELATIONAL_PREC,
+              "the left side of a condition must stop at = as well as at < and >");
+
 /*
  * Implementation notes: parseExp
  * ------------------------------
  * This code just reads an expression and then checks for extra tokens.
  */
 
-Expression *parseExp(TokenScanner &scanner) {
-    Expression *exp = readE(scanner);
-    if (scanner.hasMoreTokens()) {
-        error("parseExp: Found extra token: " + scanner.nextToken());
+ParseResult parseExp(Lexer &lexer) {
+    const ParseResult result = readE(lexer);
+    if (result.ok() && lexer.hasMoreTokens()) {
+        return failure(EXTRA_TOKEN, lexer, lexer.peek());
     }
-    return exp;
+    return result;
 }
 
 /*
  * Implementation notes: readE
- * Usage: exp = readE(scanner, prec);
- * ----------------------------------
- * This version of readE uses precedence to resolve the ambiguity in
- * the grammar.  At each recursive level, the parser reads operators and
- * subexpressions until it finds an operator whose precedence is greater
- * than the prevailing one.  When a higher-precedence operator is found,
- * readE calls itself recursively to read in that subexpression as a unit.
+ * Usage: result = readE(lexer, prec);
+ * -----------------------------------
+ * The loop of the Pratt parser.  After the first term, readE keeps
+ * taking operators that bind more tightly than prec, reading the right
+ * operand of each with the operator's own binding power as the new
+ * limit (one less for a right-associative operator).  The operator is
+ * only looked at, not taken, until it is known to belong to this
+ * level.  The first failure ends the parse and is passed up as it is.
+ *
+ * The prec the caller asks for is also the floor of the whole
+ * expression, which the operands keep: a unary minus anywhere in it
+ * reads on down to the floor, not just down to its own operator.
  */
 
-Expression *readE(TokenScanner &scanner, int prec) {
-    Expression *exp = readT(scanner);
-    std::string token;
-    while (true) {
-        token = scanner.nextToken();
-        int newPrec = precedence(token);
-        if (newPrec <= prec) break;
-        Expression *rhs = readE(scanner, newPrec);
-        exp = new CompoundExp(token, exp, rhs);
+ParseResult readE(Lexer &lexer, int prec) {
+    return readExpression(lexer, prec, prec);
+}
+
+static ParseResult readExpression(Lexer &lexer, int prec, int floor) {
+    ParseResult result = readTerm(lexer, floor);
+    while (result.ok()) {
+        const InfixRule &rule = INFIX[lexer.peek().kind];
+        if (rule.power <= prec) break;
+        lexer.next();
+        const ParseResult rhs = readExpression(lexer, rule.rightAssociative ? rule.power - 1 : rule.power, floor);
+        if (!rhs.ok()) {
+            return rhs;
+        }
+        result.exp = rule.make(result.exp, rhs.exp);
     }
-    scanner.saveToken(token);
-    return exp;
+    return result;
 }
 
 /*
  * Implementation notes: readT
  * ---------------------------
- * This function scans a term, which is either an integer, an identifier,
- * or a parenthesized subexpression.
+ * This function reads a term by handing its first token to the prefix
+ * rule for the token's kind.
  */
 
-Expression *readT(TokenScanner &scanner) {
-    std::string token = scanner.nextToken();
-    TokenType type = scanner.getTokenType(token);
-    if (type == WORD) return new IdentifierExp(token);
-    if (type == NUMBER) return new ConstantExp(stringToInteger(token));
-    if (token == "-") return new CompoundExp(token, new ConstantExp(0), readE(scanner));
-    if (token != "(") error("Illegal term in expression");
-    Expression *exp = nullptr;
-    try {
-        exp = readE(scanner);
-        if (scanner.nextToken() != ")") {
-            error("Unbalanced parentheses in expression");
-        }
-    } catch (ErrorException &ex) {
-        delete exp;
+ParseResult readT(Lexer &lexer) {
+    return readTerm(lexer, 0);
+}
+
+static ParseResult readTerm(Lexer &lexer, int floor) {
+    const Token token = lexer.next();
+    const PrefixRule rule = PREFIX[token.kind];
+    if (rule == nullptr) {
+        return failure(ILLEGAL_TERM, lexer, token);
+    }
+    return rule(lexer, token, floor);
+}
+
+/*
+ * Implementation notes: readCondition
+ * -----------------------------------
+ * The left operand is read at the relational level, so it stops at
+ * =, < or > as well as at anything that cannot continue it, and so
+ * does a negation inside it.
+ */
+
+ParseResult readCondition(Lexer &lexer, TokenKind &relation, Expression *&rhs) {
+    const ParseResult lhs = readE(lexer, RELATIONAL_PREC);
+    if (!lhs.ok()) {
+        return lhs;
+    }
+    const Token token = lexer.next();
+    if (token.kind != EQUALS_TOKEN && token.kind != LESS_TOKEN && token.kind != GREATER_TOKEN) {
+        return failure(MISSING_RELATION, lexer, token);
     }
-    return exp;
+    relation = token.kind;
+    const ParseResult right = readE(lexer);
+    if (!right.ok()) {
+        return right;
+    }
+    rhs = right.exp;
+    return lhs;
 }
 
 /*
- * Implementation notes: precedence
- * --------------------------------
- * This function checks the token against each of the defined operators
- * and returns the appropriate precedence value.
+ * Implementation notes: simplifyExp
+ * ---------------------------------
+ * The tree is simplified bottom-up, so a constant operand may itself
+ * be the result of folding.  A few cases are deliberately left alone:
+ *
+ * - Division by zero, and INT_MIN / -1, which would trap here instead
+ *   of when the line runs.
+ * - x * 0, which would hide VARIABLE NOT DEFINED for an unset x.
+ * - The left side of an assignment: (x + 0) = 1 must still fail with
+ *   "Illegal variable in assignment" rather than become x = 1.
+ *
+ * Folding uses unsigned arithmetic so that overflow wraps exactly as
+ * the evaluator's int arithmetic does on the machines we run on.
  */
 
-int precedence(std::string token) {
-    if (token == "=") return 1;
-    if (token == "+" || token == "-") return 2;
-    if (token == "*" || token == "/") return 3;
-    return 0;
+Expression *simplifyExp(Expression *exp, int &removed) {
+    if (exp == nullptr || exp->getType() != COMPOUND) {
+        return exp;
+    }
+    auto *compound = (CompoundExp *) exp;
+    const std::string op = compound->getOp();
+    compound->setRHS(simplifyExp(compound->getRHS(), removed));
+    if (op == "=") { // 赋值的左边保持原样
+        return exp;
+    }
+    compound->setLHS(simplifyExp(compound->getLHS(), removed));
+    Expression *lhs = compound->getLHS();
+    Expression *rhs = compound->getRHS();
+    if (lhs == nullptr || rhs == nullptr) {
+        return exp;
+    }
+    const bool lhsConstant = lhs->getType() == CONSTANT;
+    const bool rhsConstant = rhs->getType() == CONSTANT;
+    const int left = lhsConstant ? ((ConstantExp *) lhs)->getValue() : 0;
+    const int right = rhsConstant ? ((ConstantExp *) rhs)->getValue() : 0;
+
+    if (lhsConstant && rhsConstant) { // 两边都是常数，直接算出来
+        const unsigned a = left, b = right;
+        int value;
+        if (op == "+") {
+            value = int(a + b);
+        } else if (op == "-") {
+            value = int(a - b);
+        } else if (op == "*") {
+            value = int(a * b);
+        } else if (op == "/" && right != 0 && !(left == INT_MIN && right == -1)) {
+            value = left / right;
+        } else {
+            return exp; // 留到运行时报错
+        }
+        delete exp;
+        removed += 2;
+        return new ConstantExp(value);
+    }
+
+    Expression *keep = nullptr; // 恒等式中保留下来的那一边
+    if (rhsConstant && (((op == "+" || op == "-") && right == 0) || ((op == "*" || op == "/") && right == 1))) {
+        keep = lhs;
+        compound->setLHS(nullptr);
+    } else if (lhsConstant && ((op == "+" && left == 0) || (op == "*" && left == 1))) {
+        keep = rhs;
+        compound->setRHS(nullptr);
+    }
+    if (keep == nullptr) {
+        return exp;
+    }
+    delete exp;
+    removed += 2;
+    return keep;
 }
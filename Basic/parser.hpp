@@ -7,55 +7,122 @@
 #ifndef _parser_h
 #define _parser_h
 
+#include <cstddef>
 #include <string>
 #include <iostream>
 #include "exp.hpp"
+#include "lexer.hpp"
 
-#include "Utils/tokenScanner.hpp"
 #include "Utils/error.hpp"
 #include "Utils/strlib.hpp"
 
 
+/*
+ * Type: ParseError
+ * ----------------
+ * The reason an expression could not be parsed.
+ */
+
+enum ParseError : unsigned char {
+    PARSE_OK,
+    ILLEGAL_TERM,           // 这个记号不能开始一项
+    UNBALANCED_PARENTHESES, // ( 没有配对的 )
+    ILLEGAL_INTEGER,        // 数字不是 int 范围内的整数
+    EXTRA_TOKEN,            // 表达式之后还有东西
+    MISSING_RELATION        // 条件的左边之后不是 = < >
+};
+
+/*
+ * Type: ParseResult
+ * -----------------
+ * The outcome of a parse: the expression read, or the reason the
+ * parse failed together with the position in the line (see
+ * Lexer::offsetOf) of the token it failed at.  The parse functions
+ * below report failures this way instead of raising errors.  The
+ * nodes of a failed parse are left to the current arena.
+ */
+
+struct ParseResult {
+    Expression *exp;
+    ParseError error;
+    std::size_t position;
+
+    [[nodiscard]] bool ok() const {
+        return error == PARSE_OK;
+    }
+};
+
 /*
  * Function: parseExp
- * Usage: Expression *exp = parseExp(scanner);
- * -------------------------------------------
- * Parses an expression by reading tokens from the scanner, which must
- * be provided by the client.  The scanner should be set to ignore
- * whitespace and to scan numbers.
+ * Usage: ParseResult result = parseExp(lexer);
+ * --------------------------------------------
+ * Parses an expression by reading tokens from the lexer, which must
+ * be provided by the client, and checks that the line ends there.
  */
 
-Expression *parseExp(TokenScanner &scanner);
+ParseResult parseExp(Lexer &lexer);
 
 /*
  * Function: readE
- * Usage: Expression *exp = readE(scanner, prec);
- * ----------------------------------------------
- * Returns the next expression from the scanner involving only operators
- * whose precedence is at least prec.  The prec argument is optional and
+ * Usage: ParseResult result = readE(lexer, prec);
+ * -----------------------------------------------
+ * Reads the next expression from the lexer involving only operators
+ * that bind more tightly than prec.  The prec argument is optional and
  * defaults to 0, which means that the function reads the entire expression.
+ * The binding powers are those of the operator table in parser.cpp:
+ * 1 for =, 2 for + and -, 3 for * and /.
  */
 
-Expression *readE(TokenScanner &scanner, int prec = 0);
+ParseResult readE(Lexer &lexer, int prec = 0);
 
 /*
  * Function: readT
- * Usage: Expression *exp = readT(scanner);
- * ----------------------------------------
- * Returns the next individual term, which is either a constant, an
+ * Usage: ParseResult result = readT(lexer);
+ * -----------------------------------------
+ * Reads the next individual term, which is either a constant, an
  * identifier, or a parenthesized subexpression.
  */
 
-Expression *readT(TokenScanner &scanner);
+ParseResult readT(Lexer &lexer);
+
+/*
+ * Function: readCondition
+ * Usage: ParseResult lhs = readCondition(lexer, relation, rhs);
+ * -------------------------------------------------------------
+ * Reads the condition of an IF statement, two expressions joined by
+ * one of the relational operators =, < or >.  Returns the left
+ * expression and stores the kind of the operator's token (EQUALS_TOKEN,
+ * LESS_TOKEN or GREATER_TOKEN) in relation and the right expression
+ * in rhs; if either side fails, the result carries the error.  The
+ * relational operators bind more loosely than the arithmetic ones, so
+ * the left expression ends at the first operator that is not
+ * arithmetic, which must be a relational one.  The right expression
+ * is read whole and may itself contain an assignment.
+ */
+
+ParseResult readCondition(Lexer &lexer, TokenKind &relation, Expression *&rhs);
+
+/*
+ * Function: simplifyExp
+ * Usage: exp = simplifyExp(exp, removed);
+ * ---------------------------------------
+ * Folds the constant subexpressions of exp and drops operations that
+ * leave their other operand unchanged (x + 0, x - 0, 0 + x, x * 1,
+ * 1 * x, x / 1).  The tree is rewritten in place and its new root is
+ * returned; nodes that are no longer needed are deleted and counted
+ * in removed.  Anything that could raise an error when it is
+ * evaluated, a division by zero for instance, is left for run time.
+ */
+
+Expression *simplifyExp(Expression *exp, int &removed);
 
 /*
- * Function: precedence
- * Usage: int prec = precedence(token);
- * ------------------------------------
- * Returns the precedence of the specified operator token.  If the token
- * is not an operator, precedence returns 0.
+ * Constant: RELATIONAL_PREC
+ * -------------------------
+ * The binding power of the relational operators, the same as that of
+ * assignment, so readE(lexer, RELATIONAL_PREC) reads an operand of one.
  */
 
-int precedence(std::string token);
+const int RELATIONAL_PREC = 1;
 
 #endif
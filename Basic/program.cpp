@@ -1,113 +1,512 @@
 /*
  * File: program.cpp
  * -----------------
- * This file is a stub implementation of the program.h interface
- * in which none of the methods do anything beyond returning a
- * value of the correct type.  Your job is to fill in the bodies
- * of each of these methods with an implementation that satisfies
- * the performance guarantees specified in the assignment.
+ * This file implements the program.h interface.  The lines of the
+ * program are kept in a vector sorted by line number, which makes
+ * a lookup a binary search and stepping to the following line a
+ * single increment of the cursor.  New lines typed out of order wait
+ * in a side buffer and are merged into the vector all at once.
  */
 
+#include <algorithm>
+#include <utility>
 #include "program.hpp"
 
 
-Program::Program() = default;
+Program::Program() : cursor(0), relinkAll(true), garbage(0) {}
 
-Program::~Program() = default;
+Program::~Program() {
+    clear();
+}
 
 void Program::clear() {
-    // Replace this stub with your own code
-    //todo
-    info.clear(); // 清除所有的源代码
-
     // 清除所有的解析对象，确保删除指针避免内存泄漏
-    for (auto &entry : storage) {
-        delete entry.second;
+    for (auto &entry : lines) {
+        delete entry.stmt;
     }
-    storage.clear();
+    for (auto &entry : pending) {
+        delete entry.stmt;
+    }
+    lines.clear();
+    pending.clear();
+    file.reset();
+    expressions.clear();
+    garbage = 0;
+    cursor = 0;
+    dirtyLines.clear();
+    branchesTo.clear();
+    relinkAll = true;
+}
+
+/*
+ * Implementation notes: addSourceLine
+ * -----------------------------------
+ * The text of a typed line is copied into an arena of its own, not
+ * into the arena of the statement: setParsedStatement replaces the
+ * statement's arena, and the text has to stay.  Arena blocks do not
+ * move, so the view into the copy stays valid as the index changes.
+ *
+ * A new line that belongs in the middle of the index is not inserted
+ * there, which would shift every line after it, but appended to
+ * pending; mergePending sorts it in when the index is next read.
+ * Typing a program in descending order thus costs one merge instead
+ * of a shift per line.  A line that is already in the index is still
+ * replaced where it is.  A line whose number is already waiting in
+ * pending is appended once more, and the merge keeps the later one.
+ */
 
-    // 清除执行次数
-    executionCount.clear();
+static std::string_view copyText(Arena &text, const std::string &line) {
+    char *copy = static_cast<char *>(text.allocate(line.size()));
+    std::copy(line.begin(), line.end(), copy);
+    return std::string_view(copy, line.size());
 }
 
 void Program::addSourceLine(int lineNumber, const std::string &line) {
-    // Replace this stub with your own code
-    //todo
-    deleteParsedStatement(lineNumber);
-    info[lineNumber] = line;
-    executionCount[lineNumber] = 0;
+    markDirty(lineNumber);
+    Arena text;
+    const std::string_view source = copyText(text, line);
+    // 行号递增输入时直接追加，不需要二分；pending 里的行号都比末尾小
+    if (lines.empty() || lines.back().lineNumber < lineNumber) {
+        lines.push_back({lineNumber, source, nullptr, 0, Arena(), std::move(text)});
+        cursor = lines.size() - 1;
+        return;
+    }
+    auto it = std::lower_bound(lines.begin(), lines.end(), lineNumber,
+                               [](const Line &entry, int n) { return entry.lineNumber < n; });
+    if (it != lines.end() && it->lineNumber == lineNumber) { // 已存在则替换
+        retire(it->stmt);
+        it->stmt = nullptr;
+        it->source = source;
+        it->folded = 0;
+        it->nodes = Arena();
+        it->text = std::move(text);
+        cursor = it - lines.begin();
+        reclaimExpressions();
+    } else { // 插在中间的新行先放进 pending，下次查找时一起归并
+        pending.push_back({lineNumber, source, nullptr, 0, Arena(), std::move(text)});
+    }
 }
 
-void Program::removeSourceLine(int lineNumber) {
-    // Replace this stub with your own code
-    //todo
-    info.erase(lineNumber);
-    deleteParsedStatement(lineNumber);
-    executionCount.erase(lineNumber);
-}
+/*
+ * Implementation notes: loadLines
+ * -------------------------------
+ * A stable sort keeps lines with the same number in the order they
+ * were given, so the last of each run is the one to keep.  The others
+ * are deleted before their arenas are dropped together with their
+ * entries.
+ */
 
-std::string Program::getSourceLine(int lineNumber) {
-    // Replace this stub with your own code
-    //todo
-    if (info.find(lineNumber) != info.end()) {
-        return info[lineNumber];
+void Program::loadLines(std::vector<Line> batch, std::unique_ptr<MappedFile> file) {
+    for (auto &entry : lines) {
+        delete entry.stmt;
     }
-    return "";
+    for (auto &entry : pending) {
+        delete entry.stmt;
+    }
+    pending.clear();
+    expressions.clear();
+    garbage = 0;
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Line &a, const Line &b) { return a.lineNumber < b.lineNumber; });
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (i + 1 < batch.size() && batch[i + 1].lineNumber == batch[i].lineNumber) { // 后面还有同号的行
+            delete batch[i].stmt;
+            continue;
+        }
+        if (batch[i].stmt == nullptr) { // 只有行号，删掉这一行
+            continue;
+        }
+        batch[i].stmt->setLineNumber(batch[i].lineNumber);
+        if (kept != i) {
+            batch[kept] = std::move(batch[i]);
+        }
+        ++kept;
+    }
+    batch.erase(batch.begin() + kept, batch.end());
+    lines = std::move(batch);
+    this->file = std::move(file);
+    cursor = 0;
+    dirtyLines.clear();
+    branchesTo.clear();
+    relinkAll = true;
 }
 
-void Program::setParsedStatement(int lineNumber, Statement *stmt) {
-    // Replace this stub with your own code
-    //todo
-    if (storage.find(lineNumber) != storage.end()) { // 如果之前存在 Statement，需要删除以避免内存泄漏
-        delete storage[lineNumber];
+void Program::removeSourceLine(int lineNumber) {
+    Line *entry = findLine(lineNumber);
+    if (entry == nullptr) {
+        return;
     }
+    markDirty(lineNumber);
+    retire(entry->stmt);
+    lines.erase(lines.begin() + (entry - lines.data()));
+    cursor = 0;
+    reclaimExpressions();
+}
 
-    // 更新 storage 中该行的解析对象
-    storage[lineNumber] = stmt;
+std::string_view Program::getSourceLine(int lineNumber) {
+    Line *entry = findLine(lineNumber);
+    return entry == nullptr ? std::string_view() : entry->source;
 }
 
-//void Program::removeSourceLine(int lineNumber) {
+void Program::setParsedStatement(int lineNumber, Statement *stmt, int folded, Arena nodes) {
+    // 刚加进 pending 的行直接在那里设置，不必先归并
+    Line *entry = !pending.empty() && pending.back().lineNumber == lineNumber ? &pending.back() : findLine(lineNumber);
+    if (entry == nullptr) {
+        delete stmt;
+        error("LINE NUMBER ERROR");
+    }
+    if (entry->stmt != stmt) { // 如果之前存在 Statement，需要删除以避免内存泄漏
+        retire(entry->stmt);
+        markDirty(lineNumber);
+        entry->nodes = std::move(nodes); // 旧语句析构完了才能释放它的内存
+    }
+    entry->stmt = stmt;
+    entry->folded = folded;
+    if (stmt != nullptr) {
+        stmt->setLineNumber(lineNumber);
+    }
+}
 
 Statement *Program::getParsedStatement(int lineNumber) {
-   // Replace this stub with your own code
-   //todo
-    if (storage.find(lineNumber) != storage.end()) { // 返回行号对应的解析后对象
-        return storage[lineNumber];
+    Line *entry = findLine(lineNumber);
+    return entry == nullptr ? nullptr : entry->stmt; // 找不到就返回空指针
+}
+
+int Program::getFoldedNodes() {
+    mergePending();
+    int total = 0;
+    for (const auto &entry : lines) {
+        total += entry.folded;
     }
-    return nullptr; // 找不到就返回空指针
+    return total;
+}
+
+std::size_t Program::getNodeBytes() {
+    mergePending();
+    std::size_t total = 0;
+    for (const auto &entry : lines) {
+        total += entry.nodes.getBytes();
+    }
+    return total;
+}
+
+int Program::getLineCount() {
+    mergePending();
+    return int(lines.size());
 }
 
 int Program::getFirstLineNumber() {
-    if (info.empty()) {
+    mergePending();
+    if (lines.empty()) {
         return -1;
     }
-    int minLine = INT_MAX;
-    for (const auto &p : info) {
-        minLine = std::min(minLine, p.first);
-    }
-    return minLine;
+    cursor = 0;
+    return lines.front().lineNumber;
 }
 
 int Program::getNextLineNumber(int lineNumber) {
-    int minLine = INT_MAX;
-    bool found = false;
-    for (const auto &p : info) {
-        if (p.first > lineNumber) {
-            minLine = std::min(minLine, p.first);
-            found = true;
+    mergePending();
+    std::size_t next;
+    if (cursor < lines.size() && lines[cursor].lineNumber == lineNumber) {
+        next = cursor + 1;
+    } else {
+        next = std::upper_bound(lines.begin(), lines.end(), lineNumber,
+                                [](int n, const Line &entry) { return n < entry.lineNumber; }) - lines.begin();
+    }
+    if (next >= lines.size()) {
+        return -1; // 没有下一行
+    }
+    cursor = next;
+    return lines[next].lineNumber;
+}
+
+void Program::AddTimes(int lineNumber) {
+    Line *entry = findLine(lineNumber);
+    if (entry != nullptr && entry->stmt != nullptr) {
+        entry->stmt->AddTimes();
+    }
+}
+
+/*
+ * Implementation notes: link
+ * --------------------------
+ * A full link walks the whole index.  After a few edits it is much
+ * cheaper to patch the links around each edited line: the line
+ * itself, its predecessor and the branches recorded in branchesTo
+ * for that line number.  When the edits touch a sizeable part of
+ * the program the full walk wins again, and markDirty switches
+ * back to it.
+ *
+ * The bytecode also needs to know which statements start a basic
+ * block, and an edit can change that for two more statements: the
+ * line after the edited one, whose predecessor changed, and the
+ * target of a new branch.  Both are recompiled as well.  Whether a
+ * statement leads a block is only decided when it is compiled, after
+ * branchesTo has taken in every new branch.  The branches that are
+ * relinked because their target line changed keep their current
+ * status.  A statement that stops being a leader may keep its
+ * OP_BLOCK, which is harmless.
+ */
+
+Statement *Program::link() {
+    mergePending();
+    reclaimExpressions();
+    if (code.needsCompaction()) {
+        relinkAll = true;
+    }
+    if (relinkAll) {
+        branchesTo.clear();
+        code.clear();
+        for (auto &entry : lines) {
+            if (entry.stmt != nullptr) {
+                entry.stmt->setCodeEntry(-1);
+            }
+        }
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            relinkAt(i);
+            Statement *stmt = lines[i].stmt;
+            if (stmt != nullptr && stmt->getTargetLine() >= 0) {
+                branchesTo.emplace(stmt->getTargetLine(), stmt);
+            }
+        }
+        for (std::size_t i = 0; i < lines.size(); ++i) { // 跳转目标都登记完了才能判断谁领头
+            Statement *stmt = lines[i].stmt;
+            if (stmt != nullptr) {
+                code.compile(stmt, stmt->getNext() != nullptr, startsBlock(i)); // 按行号顺序编译，下一行紧跟在后面
+            }
         }
+    } else {
+        std::sort(dirtyLines.begin(), dirtyLines.end());
+        dirtyLines.erase(std::unique(dirtyLines.begin(), dirtyLines.end()), dirtyLines.end());
+        for (int lineNumber : dirtyLines) {
+            std::size_t i = std::lower_bound(lines.begin(), lines.end(), lineNumber,
+                                             [](const Line &entry, int n) { return entry.lineNumber < n; }) - lines.begin();
+            std::size_t after = i; // 改动位置之后的那一行
+            if (i < lines.size() && lines[i].lineNumber == lineNumber) { // 改动后的行本身
+                relinkAt(i);
+                Statement *stmt = lines[i].stmt;
+                if (stmt != nullptr && stmt->getTargetLine() >= 0) {
+                    branchesTo.emplace(stmt->getTargetLine(), stmt);
+                    newBranches.push_back(stmt);
+                }
+                after = i + 1;
+            }
+            if (i > 0) { // 前一行的后继可能变了
+                relinkAt(i - 1);
+            }
+            if (after < lines.size()) { // 后一行的前一行变了，是否领头可能跟着变
+                relinkAt(after);
+            }
+            auto range = branchesTo.equal_range(lineNumber); // 跳到这一行的语句重新解析目标
+            for (auto it = range.first; it != range.second; ++it) {
+                it->second->link(it->second->getNext(), *this);
+                relinked.emplace_back(it->second, -1);
+            }
+        }
+        for (Statement *stmt : newBranches) { // 新的跳转目标必须领头
+            Line *target = findLine(stmt->getTargetLine());
+            if (target != nullptr && target->stmt != nullptr && target->stmt->getBlock() < 0) {
+                relinked.emplace_back(target->stmt, int(target - lines.data()));
+            }
+        }
+        std::sort(relinked.begin(), relinked.end());
+        for (std::size_t k = 0; k < relinked.size(); ++k) { // 同一条语句只编译一次
+            Statement *stmt = relinked[k].first;
+            bool leader = false;
+            for (; k < relinked.size() && relinked[k].first == stmt; ++k) {
+                const int index = relinked[k].second;
+                leader = leader || (index >= 0 ? startsBlock(index) : stmt->getBlock() >= 0);
+            }
+            --k;
+            code.compile(stmt, false, leader);
+        }
+        newBranches.clear();
     }
-    return found ? minLine : -1; // 有下一行返回下一行行号，没有就返回-1
+    code.finish();
+    relinked.clear();
+    dirtyLines.clear();
+    relinkAll = false;
+    return lines.empty() ? nullptr : lines.front().stmt;
 }
 
-//more func to add
-//todo
+/*
+ * Implementation notes: findLine
+ * ------------------------------
+ * Looks the line up with a binary search, except when the cursor
+ * already points at it.  The interpreter asks for the same line
+ * several times in a row (statement, counter, successor), so the
+ * cursor check turns those repeated lookups into a comparison.
+ */
 
-void Program::AddTimes(int lineNumber) {
-    ++executionCount[lineNumber];
-    if (executionCount[lineNumber] >= 1000) {
-        error("SYNTAX ERROR");
-        exit(1);
+Program::Line *Program::findLine(int lineNumber) {
+    mergePending();
+    if (cursor < lines.size() && lines[cursor].lineNumber == lineNumber) {
+        return &lines[cursor];
+    }
+    auto it = std::lower_bound(lines.begin(), lines.end(), lineNumber,
+                               [](const Line &entry, int n) { return entry.lineNumber < n; });
+    if (it == lines.end() || it->lineNumber != lineNumber) {
+        return nullptr;
+    }
+    cursor = it - lines.begin();
+    return &*it;
+}
+
+/*
+ * Implementation notes: mergePending
+ * ----------------------------------
+ * Sorts the waiting lines, keeps the last of each run with the same
+ * number and merges them into the index in one linear pass.  None of
+ * the waiting lines was linked yet, so the ones that were typed over
+ * only need to be retired.
+ */
+
+void Program::mergePending() {
+    if (pending.empty()) {
+        return;
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const Line &a, const Line &b) { return a.lineNumber < b.lineNumber; });
+    const std::size_t middle = lines.size();
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        if (i + 1 < pending.size() && pending[i + 1].lineNumber == pending[i].lineNumber) { // 后面又敲过同一行号
+            retire(pending[i].stmt);
+            continue;
+        }
+        lines.push_back(std::move(pending[i]));
+    }
+    pending.clear();
+    std::inplace_merge(lines.begin(), lines.begin() + middle, lines.end(),
+                       [](const Line &a, const Line &b) { return a.lineNumber < b.lineNumber; });
+    cursor = 0;
+}
+
+void Program::markDirty(int lineNumber) {
+    if (relinkAll) {
+        return;
+    }
+    dirtyLines.push_back(lineNumber);
+    if (dirtyLines.size() > lines.size() / 8 + 16) { // 改动太多，不如整体重新 link
+        dirtyLines.clear();
+        relinkAll = true;
     }
 }
 
+void Program::relinkAt(std::size_t index) {
+    Statement *stmt = lines[index].stmt;
+    if (stmt != nullptr) {
+        stmt->link(index + 1 < lines.size() ? lines[index + 1].stmt : nullptr, *this);
+        relinked.emplace_back(stmt, int(index));
+    }
+}
+
+/*
+ * Implementation notes: startsBlock
+ * ---------------------------------
+ * A line starts a basic block if it is the first line, if some branch
+ * targets it, or if the line before it never falls through into it
+ * unconditionally (GOTO, IF, END).
+ */
+
+bool Program::startsBlock(std::size_t index) const {
+    if (index == 0 || branchesTo.count(lines[index].lineNumber) > 0) {
+        return true;
+    }
+    const Statement *before = lines[index - 1].stmt;
+    if (before == nullptr) {
+        return true;
+    }
+    const StatementType type = before->getType();
+    return type == GOTO_STMT || type == IF_STMT || type == END_STMT;
+}
+
+/*
+ * Implementation notes: bindFlat
+ * ------------------------------
+ * The nodes of an expression are appended in one run, so the nodes
+ * of a statement are the ones the pool gained while it was bound.
+ */
+
+void Program::bindFlat(Statement *stmt) {
+    const int begin = expressions.size();
+    stmt->bindFlat(expressions);
+    stmt->setFlatNodes(begin, expressions.size());
+}
+
+/*
+ * Implementation notes: releaseFlat, reclaimExpressions
+ * -----------------------------------------------------
+ * The nodes of a statement that goes away are dropped at once if
+ * they are the last ones in the pool.  That is the common case of
+ * retyping the line that was entered last, because a replaced line
+ * is retired before the new statement is bound.  Nodes further in
+ * are counted as garbage.  Once garbage makes up more than half of
+ * the pool, reclaimExpressions rebuilds the pool from the statements
+ * that are still there, so the pool stays within twice the size of
+ * the live program.  The rebuild moves nodes, so it only happens
+ * where no node index is held outside the statements: when a line
+ * has been replaced or removed, and before RUN.
+ */
+
+/*
+ * Constant: MIN_GARBAGE
+ * ---------------------
+ * The pool is not rebuilt for fewer unused nodes than this, so that
+ * small programs are not rebound on every other edit.
+ */
+
+static const int MIN_GARBAGE = 4096;
+
+void Program::releaseFlat(Statement *stmt) {
+    const int begin = stmt->getFlatBegin(), end = stmt->getFlatEnd();
+    if (begin < 0) {
+        return;
+    }
+    if (end == expressions.size()) { // 在池的末尾，直接截掉
+        expressions.truncate(begin);
+    } else {
+        garbage += end - begin;
+    }
+}
+
+void Program::reclaimExpressions() {
+    if (garbage < MIN_GARBAGE || garbage <= expressions.size() / 2) {
+        return;
+    }
+    expressions.clear();
+    garbage = 0;
+    for (auto *entries : {&lines, &pending}) {
+        for (auto &entry : *entries) {
+            if (entry.stmt != nullptr && entry.stmt->getFlatBegin() >= 0) { // 只重绑原来绑过的语句
+                bindFlat(entry.stmt);
+            }
+        }
+    }
+}
+
+/*
+ * Implementation notes: retire
+ * ----------------------------
+ * Deletes a statement that is being replaced or removed, first
+ * dropping it from branchesTo so that no dangling pointer is left
+ * for a later link to follow, and giving its nodes in the expression
+ * pool back.
+ */
+
+void Program::retire(Statement *stmt) {
+    if (stmt == nullptr) {
+        return;
+    }
+    if (stmt->getTargetLine() >= 0) {
+        auto range = branchesTo.equal_range(stmt->getTargetLine());
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == stmt) {
+                branchesTo.erase(it);
+                break;
+            }
+        }
+    }
+    releaseFlat(stmt);
+    delete stmt;
+}
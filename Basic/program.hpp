@@ -10,11 +10,16 @@
 
 #include <climits>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 #include <unordered_map>
+#include "arena.hpp"
+#include "flatexp.hpp"
+#include "mapping.hpp"
 #include "statement.hpp"
+#include "vm.hpp"
 
 class Statement;
 
@@ -25,7 +30,7 @@ class Statement;
  * components:
  *
  * 1. The source line, which is the complete line (including the
- *    line number) that was entered by the user.
+ *    line number) that was entered by the user or loaded from a file.
  *
  * 2. The parsed representation of that statement, which is a
  *    pointer to a Statement.
@@ -35,6 +40,36 @@ class Program {
 
 public:
 
+/*
+ * Type: Line
+ * ----------
+ * One entry of the line index.  The index keeps every line of the
+ * program in a single vector sorted by line number, so the source
+ * text and the parsed statement of a line live side by side.  The
+ * execution counter of a line is kept on its statement.  The statement
+ * and its expressions are allocated in the line's arena.  A bulk load
+ * builds Line entries itself and hands them over with loadLines.
+ *
+ * The source text is a view.  It points into the file the program
+ * was loaded from or, for a line that was typed in, into a copy in
+ * the line's own text arena, which is freed with the line.  A loaded
+ * file is mapped if it has at least MappedFile::MAP_THRESHOLD bytes
+ * (16 MB) and read into one buffer otherwise; its lines are not
+ * copied one by one either way.  A loaded line that is edited is
+ * replaced by a copy of its own, so the file is never written to.
+ * A mapped file must stay unchanged on disk while it is loaded (see
+ * isSourceIntact).
+ */
+
+    struct Line {
+        int lineNumber;
+        std::string_view source;
+        Statement *stmt;
+        int folded; // 解析时常量折叠删掉的结点数
+        Arena nodes; // stmt 及其表达式所在的内存
+        Arena text; // 敲进来的行的文本，从文件读的行为空
+    };
+
 /*
  * Constructor: Program
  * Usage: Program program;
@@ -70,11 +105,30 @@ public:
  * If that line already exists, the text of the line replaces
  * the text of any existing line and the parsed representation
  * (if any) is deleted.  If the line is new, it is added to the
- * program in the correct sequence.
+ * program in the correct sequence.  The program keeps its own copy
+ * of the text, apart from the text of a loaded file.
  */
 
     void addSourceLine(int lineNumber, const std::string &line);
 
+/*
+ * Method: loadLines
+ * Usage: program.loadLines(std::move(batch), std::move(file));
+ * ------------------------------------------------------------
+ * Replaces every line of the program with the lines in batch, which
+ * may come in any order.  The source text of the lines points into
+ * file, which the program keeps until it is cleared or loaded again;
+ * the file must not be changed on disk in the meantime.  Where batch
+ * holds several lines with the same number the last one wins, as if
+ * they had been entered one after another; a line without a statement
+ * deletes its number.  The batch is sorted once and becomes the line
+ * index as a whole, instead of being inserted line by line.  The
+ * expression pool is emptied together with the old lines, so the new
+ * ones must not be bound to it before they are loaded.
+ */
+
+    void loadLines(std::vector<Line> batch, std::unique_ptr<MappedFile> file);
+
 /*
  * Method: removeSourceLine
  * Usage: program.removeSourceLine(lineNumber);
@@ -89,25 +143,30 @@ public:
 
 /*
  * Method: getSourceLine
- * Usage: string line = program.getSourceLine(lineNumber);
- * -------------------------------------------------------
+ * Usage: std::string_view line = program.getSourceLine(lineNumber);
+ * -----------------------------------------------------------------
  * Returns the program line with the specified line number.
  * If no such line exists, this method returns the empty string.
+ * The view is valid until the line is changed or removed.
  */
 
-    std::string getSourceLine(int lineNumber);
+    std::string_view getSourceLine(int lineNumber);
 
 /*
  * Method: setParsedStatement
- * Usage: program.setParsedStatement(lineNumber, stmt);
- * ----------------------------------------------------
+ * Usage: program.setParsedStatement(lineNumber, stmt, folded, std::move(nodes));
+ * ------------------------------------------------------------------------------
  * Adds the parsed representation of the statement to the statement
  * at the specified line number.  If no such line exists, this
  * method raises an error.  If a previous parsed representation
- * exists, the memory for that statement is reclaimed.
+ * exists, the memory for that statement is reclaimed.  The optional
+ * folded argument records how many expression nodes simplifyExp
+ * removed while the statement was parsed.  The optional nodes
+ * argument is the arena the statement was allocated from, which the
+ * program keeps with the line and frees when the line goes.
  */
 
-    void setParsedStatement(int lineNumber, Statement *stmt);
+    void setParsedStatement(int lineNumber, Statement *stmt, int folded = 0, Arena nodes = Arena());
 
 /*
  * Method: getParsedStatement
@@ -120,6 +179,48 @@ public:
 
     Statement *getParsedStatement(int lineNumber);
 
+/*
+ * Method: getFoldedNodes
+ * Usage: int removed = program.getFoldedNodes();
+ * ----------------------------------------------
+ * Returns the number of expression nodes that constant folding
+ * removed from the statements currently in the program.
+ */
+
+    int getFoldedNodes();
+
+/*
+ * Method: getNodeBytes
+ * Usage: std::size_t bytes = program.getNodeBytes();
+ * --------------------------------------------------
+ * Returns the number of bytes the statements of the program and
+ * their expressions take up in the arenas of their lines.
+ */
+
+    std::size_t getNodeBytes();
+
+/*
+ * Method: getLineCount
+ * Usage: int count = program.getLineCount();
+ * ------------------------------------------
+ * Returns the number of lines in the program.
+ */
+
+    int getLineCount();
+
+/*
+ * Method: isSourceIntact
+ * Usage: if (program.isSourceIntact()) ...
+ * ----------------------------------------
+ * Returns false if the file the program was loaded from has been
+ * changed on disk since, so that the text of its lines can no longer
+ * be read.  The parsed statements do not depend on the file and stay
+ * usable either way.
+ */
+
+    bool isSourceIntact() const {
+        return file == nullptr || file->isIntact();
+    }
 
 /*
  * Method: getFirstLineNumber
@@ -142,24 +243,104 @@ public:
 
     int getNextLineNumber(int lineNumber);
 
-    //more func to add
-    //todo
+/*
+ * Method: AddTimes
+ * Usage: program.AddTimes(lineNumber);
+ * ------------------------------------
+ * Records one more execution of the specified line.  A line that
+ * reaches 1000 executions is treated as a runaway loop and raises
+ * an error.
+ */
+
     void AddTimes(int lineNumber);
 
-private:
+/*
+ * Method: link
+ * Usage: Statement *first = program.link();
+ * -----------------------------------------
+ * Prepares the program for RUN.  Every statement learns which
+ * statement follows it, and GOTO and IF statements resolve their
+ * target lines to statements.  A target that does not exist is
+ * left unresolved and reported as LINE NUMBER ERROR when the
+ * branch is taken.  Only the links affected by edits made since
+ * the previous call are recomputed.  Returns the first statement
+ * of the program, or NULL if the program is empty.
+ */
+
+    Statement *link();
+
+/*
+ * Method: getBytecode
+ * Usage: program.getBytecode().run(first, state);
+ * -----------------------------------------------
+ * Returns the compiled form of the program.  link keeps it in step
+ * with the statements, compiling only the ones it relinked.
+ */
+
+    Bytecode &getBytecode() {
+        return code;
+    }
+
+/*
+ * Method: getExpressions
+ * Usage: stmt->bindFlat(program.getExpressions());
+ * ------------------------------------------------
+ * Returns the pool that holds the flat form of the program's
+ * expressions under --flat (see flatexp.h).  clear empties it.
+ */
 
-    // Fill this in with whatever types and instance variables you need
-    //todo
-    std::unordered_map<int, std::string> info;
-    std::unordered_map<int, Statement*> storage;
-    std::unordered_map<int, uint64_t> executionCount; // 存储每个行号的执行次数
-
-    void deleteParsedStatement(int lineNumber) {
-        if (storage.find(lineNumber) != storage.end()) {
-            delete storage[lineNumber];
-            storage.erase(lineNumber);
-        }
+    ExpPool &getExpressions() {
+        return expressions;
     }
+
+/*
+ * Method: bindFlat
+ * Usage: program.bindFlat(stmt);
+ * ------------------------------
+ * Binds a statement of the program to the expression pool and records
+ * the nodes it takes up there, so that they can be reclaimed when the
+ * statement is replaced or removed.  The statement must already be
+ * stored with setParsedStatement or loadLines.
+ */
+
+    void bindFlat(Statement *stmt);
+
+private:
+
+    std::vector<Line> lines; // 按行号升序排列
+    std::vector<Line> pending; // 乱序敲进来的新行，还没归并进 lines
+    std::unique_ptr<MappedFile> file; // LOAD 进来的源文件，行的文本指向它
+    std::size_t cursor; // 最近一次定位到的下标，顺序执行时可 O(1) 取下一行
+
+/*
+ * Link bookkeeping
+ * ----------------
+ * Edits between two RUNs only invalidate the links around the edited
+ * lines: the edited line itself, the line before it (whose successor
+ * may have changed) and every branch that targets it.  Program keeps
+ * the numbers of the edited lines and, for each target line, the
+ * branches that jump to it, so that link can patch just those.  The
+ * same statements are the only ones whose bytecode is recompiled.
+ */
+
+    std::vector<int> dirtyLines; // 上次 link 之后改动过的行号
+    bool relinkAll; // 改动太多或者刚 CLEAR 过，整体重新 link
+    std::unordered_multimap<int, Statement *> branchesTo; // 目标行号 -> 跳到该行的语句
+    std::vector<std::pair<Statement *, int>> relinked; // 本次 link 改过的语句和它的下标（-1 表示不按位置重判领头），需要重新编译
+    std::vector<Statement *> newBranches; // 本次 link 新加的跳转语句
+    Bytecode code;
+    ExpPool expressions;
+    int garbage; // 池里已经没有语句用的结点数
+
+    void releaseFlat(Statement *stmt);
+    void reclaimExpressions();
+
+    Line *findLine(int lineNumber);
+    void mergePending();
+    void markDirty(int lineNumber);
+    void relinkAt(std::size_t index);
+    bool startsBlock(std::size_t index) const;
+    void retire(Statement *stmt);
 };
 
 #endif
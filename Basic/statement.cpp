@@ -12,15 +12,23 @@
 
 /* Implementation of the Statement class */
 
-int stringToInt(std::string str);
-
-Statement::Statement() = default;
+Statement::Statement(StatementType type) : type(type), next(nullptr), executionCount(0), codeEntry(-1), block(-1),
+                                                lineNumber(-1), flatBegin(-1), flatEnd(-1) {}
 
 Statement::~Statement() = default;
 
+void Statement::link(Statement *next, Program &program) {
+    this->next = next;
+}
+
 //todo
 
-void InputStatement::execute(EvalState &state, Program &program) {
+Statement *InputStatement::execute(EvalState &state, Program &program) {
+    state.setValue(slot, readValue());
+    return getNext();
+}
+
+int InputStatement::readValue() {
     int value;
     std::string input;
 
@@ -32,8 +40,7 @@ void InputStatement::execute(EvalState &state, Program &program) {
         std::istringstream iss(input);
         if (iss >> value) {
             if (iss.eof()) {  // 确保输入只包含一个整数，没有其他多余的内容
-                state.setValue(variable, value);
-                break;
+                return value;
             }
         }
         std::cout << "INVALID NUMBER" << std::endl; // 如果输入不合法，提示用户重新输入
@@ -41,30 +48,59 @@ void InputStatement::execute(EvalState &state, Program &program) {
     }
 }
 
-void GotoStatement::execute(EvalState &state, Program &program) {
-    if (program.getSourceLine(targetLine).empty()) {
+Statement *GotoStatement::execute(EvalState &state, Program &program) {
+    if (target == nullptr) {
         error("LINE NUMBER ERROR");
     }
+    return target;
 }
 
-void IfStatement::execute(EvalState &state, Program &program) {
-    if (program.getSourceLine(targetLine).empty()) {
-        error("LINE NUMBER ERROR");
-    }
+void GotoStatement::link(Statement *next, Program &program) {
+    Statement::link(next, program);
+    target = program.getParsedStatement(targetLine);
+}
+
+/*
+ * Implementation notes: IfStatement::execute
+ * ------------------------------------------
+ * A taken branch to a line that does not exist ends the RUN quietly,
+ * unlike GOTO, which reports LINE NUMBER ERROR.  That is how RUN has
+ * always treated the two statements.
+ */
+
+Statement *IfStatement::execute(EvalState &state, Program &program) {
+    return isConditionTrue(state) ? target : getNext();
+}
+
+void IfStatement::link(Statement *next, Program &program) {
+    Statement::link(next, program);
+    target = program.getParsedStatement(targetLine);
+}
+
+void IfStatement::bindClosures() {
+    delete lhsClosure;
+    delete rhsClosure;
+    lhsClosure = new Closure(lhs);
+    rhsClosure = new Closure(rhs);
+}
+
+void IfStatement::bindFlat(ExpPool &pool) {
+    lhsNode = pool.add(lhs);
+    rhsNode = pool.add(rhs);
+    this->pool = &pool;
 }
 
 bool IfStatement::isConditionTrue(EvalState &state) const {
-    const int leftValue = lhs->eval(state);
-    const int rightValue = rhs->eval(state);
-    if (op == "=") {
-        return leftValue == rightValue;
-    } else if (op == "<") {
-        return leftValue < rightValue;
-    } else if (op == ">") {
-        return leftValue > rightValue;
-    } else {
-        error("SYNTAX ERROR");
-        return false;
+    const int leftValue = lhsClosure != nullptr ? lhsClosure->eval(state)
+                          : pool != nullptr ? pool->eval(lhsNode, state) : lhs->eval(state);
+    const int rightValue = rhsClosure != nullptr ? rhsClosure->eval(state)
+                           : pool != nullptr ? pool->eval(rhsNode, state) : rhs->eval(state);
+    switch (relation) {
+        case EQUALS_TOKEN:
+            return leftValue == rightValue;
+        case LESS_TOKEN:
+            return leftValue < rightValue;
+        default:
+            return leftValue > rightValue; // readCondition 只会给出这三种
     }
-
 }
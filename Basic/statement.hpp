@@ -12,10 +12,14 @@
 #ifndef _statement_h
 #define _statement_h
 
+#include <cstdint>
 #include <string>
 #include <sstream>
+#include "arena.hpp"
+#include "closure.hpp"
 #include "evalstate.hpp"
 #include "exp.hpp"
+#include "flatexp.hpp"
 #include "Utils/tokenScanner.hpp"
 #include "program.hpp"
 #include "parser.hpp"
@@ -24,6 +28,19 @@
 
 class Program;
 
+/*
+ * Type: StatementType
+ * -------------------
+ * This enumerated type tags each statement with its kind, so that
+ * code which has to tell statements apart (the bytecode compiler,
+ * for example) can switch on the tag instead of trying dynamic_cast
+ * once per subclass.
+ */
+
+enum StatementType {
+    LET_STMT, PRINT_STMT, INPUT_STMT, REM_STMT, GOTO_STMT, IF_STMT, END_STMT
+};
+
 /*
  * Class: Statement
  * ----------------
@@ -41,11 +58,11 @@ public:
 /*
  * Constructor: Statement
  * ----------------------
- * The base class constructor is empty.  Each subclass must provide
- * its own constructor.
+ * The base class constructor only records the kind of statement.
+ * Each subclass must provide its own constructor.
  */
 
-    Statement();
+    explicit Statement(StatementType type);
 
 /*
  * Destructor: ~Statement
@@ -60,16 +77,228 @@ public:
 
 /*
  * Method: execute
- * Usage: stmt->execute(state);
- * ----------------------------
+ * Usage: Statement *next = stmt->execute(state, program);
+ * -------------------------------------------------------
  * This method executes a BASIC statement.  Each of the subclasses
  * defines its own execute method that implements the necessary
  * operations.  As was true for the expression evaluator, this
  * method takes an EvalState object for looking up variables or
  * controlling the operation of the interpreter.
+ *
+ * The result is the statement to execute next according to the
+ * links set up by Program::link: the following line, the target of
+ * a taken branch, or NULL when the program stops.  Commands executed
+ * in immediate mode are not linked and ignore the result.
+ */
+
+    virtual Statement *execute(EvalState &state, Program &program) = 0;
+
+/*
+ * Operators: new, delete
+ * ----------------------
+ * Statements are allocated from the current arena, next to the nodes
+ * of their expressions (see arena.h).  delete runs the destructor and
+ * leaves the memory to the arena.
+ */
+
+    static void *operator new(std::size_t size) {
+        return Arena::allocateNode(size);
+    }
+
+    static void operator delete(void *block) {}
+
+/*
+ * Method: getType
+ * Usage: StatementType type = stmt->getType();
+ * --------------------------------------------
+ * Returns the kind of this statement.
+ */
+
+    [[nodiscard]] StatementType getType() const {
+        return type;
+    }
+
+/*
+ * Method: link
+ * Usage: stmt->link(next, program);
+ * ---------------------------------
+ * Called by Program::link before a RUN.  Records the statement that
+ * follows this one in line order, and gives branching statements the
+ * chance to resolve their target line to a statement once, so that
+ * the interpreter loop never has to look a line number up.
+ */
+
+    virtual void link(Statement *next, Program &program);
+
+/*
+ * Method: bindClosures
+ * Usage: stmt->bindClosures();
+ * ----------------------------
+ * Compiles the expressions of the statement into closures (see
+ * closure.h), which execute then uses instead of Expression::eval.
+ * Statements without expressions ignore the call.
+ */
+
+    virtual void bindClosures() {}
+
+/*
+ * Method: bindFlat
+ * Usage: stmt->bindFlat(pool);
+ * ----------------------------
+ * Adds the expressions of the statement to pool (see flatexp.h) and
+ * keeps the index of their roots, which execute then evaluates
+ * instead of the trees.  The pool must outlive the statement's use
+ * of it.  Statements without expressions ignore the call.
+ */
+
+    virtual void bindFlat(ExpPool &pool) {}
+
+/*
+ * Method: getNext
+ * Usage: Statement *next = stmt->getNext();
+ * -----------------------------------------
+ * Returns the statement on the following line, as recorded by the
+ * last link, or NULL if this is the last line of the program.
+ */
+
+    Statement *getNext() const {
+        return next;
+    }
+
+/*
+ * Method: getTargetLine
+ * Usage: int target = stmt->getTargetLine();
+ * ------------------------------------------
+ * Returns the line number a branching statement may jump to, or -1
+ * for statements that always continue with the following line.
+ */
+
+    [[nodiscard]] virtual int getTargetLine() const {
+        return -1;
+    }
+
+/*
+ * Method: AddTimes
+ * Usage: stmt->AddTimes();
+ * ------------------------
+ * Records one more execution of this statement.  A statement that
+ * reaches 1000 executions is treated as a runaway loop and raises
+ * an error.  The counter lives as long as the statement, so editing
+ * a line starts it again from zero.
+ */
+
+    void AddTimes() {
+        if (++executionCount >= 1000) {
+            error("SYNTAX ERROR");
+        }
+    }
+
+/*
+ * Methods: getExecutionCount, addExecutions
+ * Usage: uint64_t count = stmt->getExecutionCount();
+ *        stmt->addExecutions(passes);
+ * --------------------------------------------------
+ * Read and advance the execution counter without the limit check.
+ * The bytecode machine counts executions per basic block and uses
+ * these to credit them to the statements of the block; it checks
+ * the limit itself.
+ */
+
+    [[nodiscard]] uint64_t getExecutionCount() const {
+        return executionCount;
+    }
+
+    void addExecutions(uint64_t passes) {
+        executionCount += passes;
+    }
+
+/*
+ * Methods: getCodeEntry, setCodeEntry
+ * Usage: int pc = stmt->getCodeEntry();
+ *        stmt->setCodeEntry(pc);
+ * -------------------------------------
+ * The address of this statement's code in the program's bytecode,
+ * or -1 if the statement has not been compiled yet.  These are
+ * maintained by the Bytecode class.
+ */
+
+    [[nodiscard]] int getCodeEntry() const {
+        return codeEntry;
+    }
+
+    void setCodeEntry(int pc) {
+        codeEntry = pc;
+    }
+
+/*
+ * Methods: getBlock, setBlock
+ * Usage: if (stmt->getBlock() >= 0) ...
+ *        stmt->setBlock(index);
+ * -------------------------------------
+ * The index of the basic block this statement leads in the program's
+ * bytecode, or -1 if it is not compiled as a leader.  These are
+ * maintained by the Bytecode class.
+ */
+
+    [[nodiscard]] int getBlock() const {
+        return block;
+    }
+
+    void setBlock(int index) {
+        block = index;
+    }
+
+/*
+ * Methods: getLineNumber, setLineNumber
+ * Usage: int lineNumber = stmt->getLineNumber();
+ *        stmt->setLineNumber(lineNumber);
+ * ----------------------------------------------
+ * The number of the program line this statement was parsed from, or
+ * -1 for a statement executed in immediate mode.  It is set when the
+ * statement is stored in the program.
+ */
+
+    [[nodiscard]] int getLineNumber() const {
+        return lineNumber;
+    }
+
+    void setLineNumber(int lineNumber) {
+        this->lineNumber = lineNumber;
+    }
+
+/*
+ * Methods: getFlatBegin, getFlatEnd, setFlatNodes
+ * Usage: int begin = stmt->getFlatBegin();
+ *        stmt->setFlatNodes(begin, end);
+ * ----------------------------------------------
+ * The nodes from begin up to end that the expressions of this
+ * statement take up in the program's expression pool, or -1 for both
+ * if the statement is not bound to the pool.  These are maintained
+ * by the Program class.
  */
 
-    virtual void execute(EvalState &state, Program &program) = 0;
+    [[nodiscard]] int getFlatBegin() const {
+        return flatBegin;
+    }
+
+    [[nodiscard]] int getFlatEnd() const {
+        return flatEnd;
+    }
+
+    void setFlatNodes(int begin, int end) {
+        flatBegin = begin;
+        flatEnd = end;
+    }
+
+private:
+    const StatementType type;
+    Statement *next;
+    uint64_t executionCount; // 执行次数
+    int codeEntry; // 字节码入口
+    int block; // 领头的基本块
+    int lineNumber; // 所在的行号
+    int flatBegin; // 在表达式池里占的结点区间 [flatBegin, flatEnd)
+    int flatEnd;
 
 };
 
@@ -87,58 +316,125 @@ public:
 
 class LetStatement : public Statement {
 public:
-    LetStatement(const std::string &var, Expression *exp) {
+    LetStatement(const std::string &var, Expression *exp) : Statement(LET_STMT) {
         variable = var;
+        slot = EvalState::slotOf(var);
         this->exp = exp;
     }
     ~LetStatement() override {
         delete exp;
+        delete closure;
     }
-    void execute(EvalState &state, Program &program) override {
-        const int value = exp->eval(state); // 计算表达式的值
-        state.setValue(variable, value); // 把结果存到state里
+    Statement *execute(EvalState &state, Program &program) override {
+        const int value = closure != nullptr ? closure->eval(state)
+                          : pool != nullptr ? pool->eval(node, state) : exp->eval(state); // 计算表达式的值
+        state.setValue(slot, value); // 把结果存到state里
+        return getNext();
+    }
+
+    void bindClosures() override {
+        delete closure;
+        closure = new Closure(exp);
+    }
+
+    void bindFlat(ExpPool &pool) override {
+        node = pool.add(exp);
+        this->pool = &pool;
+    }
+
+    [[nodiscard]] const std::string &getVariable() const {
+        return variable;
+    }
+
+    [[nodiscard]] int getSlot() const {
+        return slot;
     }
+
+    [[nodiscard]] Expression *getExp() const {
+        return exp;
+    }
+
 private:
     std::string variable; // 存放要修改/定义的变量名
+    int slot; // 变量的槽位
     Expression *exp; // 存放表达式
+    Closure *closure = nullptr; // --closures 时编译好的表达式
+    const ExpPool *pool = nullptr; // --flat 时表达式所在的池
+    int node = -1; // 池里的根结点
 };
 
 class PrintStatement : public Statement {
 public:
-    explicit PrintStatement(Expression *exp) {
+    explicit PrintStatement(Expression *exp) : Statement(PRINT_STMT) {
         this->exp = exp;
     }
     ~PrintStatement() override {
         delete exp;
+        delete closure;
     }
-    void execute(EvalState &state, Program &program) override {
-        const int value = exp->eval(state);
+    Statement *execute(EvalState &state, Program &program) override {
+        const int value = closure != nullptr ? closure->eval(state)
+                          : pool != nullptr ? pool->eval(node, state) : exp->eval(state);
         std::cout << value << std::endl;
+        return getNext();
+    }
+
+    void bindClosures() override {
+        delete closure;
+        closure = new Closure(exp);
+    }
+
+    void bindFlat(ExpPool &pool) override {
+        node = pool.add(exp);
+        this->pool = &pool;
+    }
+
+    [[nodiscard]] Expression *getExp() const {
+        return exp;
     }
+
 private:
     Expression *exp;
+    Closure *closure = nullptr;
+    const ExpPool *pool = nullptr;
+    int node = -1;
 };
 
 class InputStatement : public Statement {
 public:
-    explicit InputStatement(const std::string &var) : variable(var) {}
+    explicit InputStatement(const std::string &var)
+            : Statement(INPUT_STMT), variable(var), slot(EvalState::slotOf(var)) {}
 
     ~InputStatement() override = default;
 
-    void execute(EvalState &state, Program &program) override;
+    Statement *execute(EvalState &state, Program &program) override;
+
+    [[nodiscard]] const std::string &getVariable() const {
+        return variable;
+    }
+
+    [[nodiscard]] int getSlot() const {
+        return slot;
+    }
+
+    // 读入一个整数，不合法时提示 INVALID NUMBER 并重新读
+    static int readValue();
 
 private:
     std::string variable;
+    int slot;
 };
 
 class RemStatement : public Statement {
 public:
-    explicit RemStatement(const std::string &text) {
+    explicit RemStatement(const std::string &text) : Statement(REM_STMT) {
         commentText = text;
     }
     ~RemStatement() override = default;
 
-    void execute(EvalState &state, Program &program) override {} // 啥也不干
+    Statement *execute(EvalState &state, Program &program) override { // 啥也不干
+        return getNext();
+    }
 
 private:
     std::string commentText; // 仅用于存储注释内容
@@ -146,26 +442,35 @@ private:
 
 class GotoStatement : public Statement {
 public:
-    explicit GotoStatement(const int lineNumber) {
+    explicit GotoStatement(const int lineNumber) : Statement(GOTO_STMT) {
         targetLine = lineNumber;
     }
     ~GotoStatement() override = default;
 
-    void execute(EvalState &state, Program &program) override;
+    Statement *execute(EvalState &state, Program &program) override;
 
-    [[nodiscard]] int getTargetLine() const {
+    void link(Statement *next, Program &program) override;
+
+    [[nodiscard]] int getTargetLine() const override {
         return targetLine;
     }
 
+    // 目标行的语句，目标行不存在时为 nullptr
+    [[nodiscard]] Statement *getTarget() const {
+        return target;
+    }
+
 private:
     int targetLine;
+    Statement *target = nullptr;
 };
 
 class IfStatement : public Statement {
 public:
-    IfStatement(Expression *lhs, const std::string &op, Expression *rhs, const int targetLine) {
+    IfStatement(Expression *lhs, TokenKind relation, Expression *rhs, const int targetLine)
+            : Statement(IF_STMT) {
         this->lhs = lhs;
-        this->op = op;
+        this->relation = relation;
         this->rhs = rhs;
         this->targetLine = targetLine;
     }
@@ -173,32 +478,63 @@ public:
     ~IfStatement() override {
         delete lhs;
         delete rhs;
+        delete lhsClosure;
+        delete rhsClosure;
     }
 
-    void execute(EvalState &state, Program &program) override;
+    Statement *execute(EvalState &state, Program &program) override;
+
+    void link(Statement *next, Program &program) override;
+
+    void bindClosures() override;
+
+    void bindFlat(ExpPool &pool) override;
 
     // 判断表达式正误
     bool isConditionTrue(EvalState &state) const;
 
-    [[nodiscard]] int getTargetLine() const {
+    [[nodiscard]] Expression *getLHS() const {
+        return lhs;
+    }
+
+    // 关系运算符的记号种类：EQUALS_TOKEN、LESS_TOKEN 或 GREATER_TOKEN
+    [[nodiscard]] TokenKind getRelation() const {
+        return relation;
+    }
+
+    [[nodiscard]] Expression *getRHS() const {
+        return rhs;
+    }
+
+    [[nodiscard]] int getTargetLine() const override {
         return targetLine;
     }
 
+    // 目标行的语句，目标行不存在时为 nullptr
+    [[nodiscard]] Statement *getTarget() const {
+        return target;
+    }
+
 private:
     Expression *lhs;
-    std::string op;
+    TokenKind relation;
     Expression *rhs;
     int targetLine;
+    Statement *target = nullptr;
+    Closure *lhsClosure = nullptr;
+    Closure *rhsClosure = nullptr;
+    const ExpPool *pool = nullptr;
+    int lhsNode = -1;
+    int rhsNode = -1;
 };
 
 class EndStatement : public Statement {
 public:
-    EndStatement() = default;
+    EndStatement() : Statement(END_STMT) {}
     ~EndStatement() override = default;
-    void execute(EvalState &state, Program &program) override {
-        exit(0);
+    Statement *execute(EvalState &state, Program &program) override { // 程序到此结束
+        return nullptr;
     }
-private:
 };
 
 #endif
@@ -0,0 +1,97 @@
+/*
+ * File: tier.cpp
+ * --------------
+ * This file implements the tiering manager declared in tier.h.
+ */
+
+#include <algorithm>
+#include "tier.hpp"
+#include "program.hpp"
+#include "statement.hpp"
+
+
+TierManager::TierManager() : promotions(0) {}
+
+/*
+ * Implementation notes: run
+ * -------------------------
+ * A branch was taken when the statement returned by execute is its
+ * target rather than the next line.  The loop is found the first time
+ * a backward branch gets hot; if it cannot be entered in the bytecode
+ * tier (which only happens if its head does not lead a basic block),
+ * the branch simply stays in the tree-walking loop.
+ */
+
+static Statement *targetOf(Statement *stmt) {
+    if (stmt->getType() == GOTO_STMT) {
+        return static_cast<GotoStatement *>(stmt)->getTarget();
+    }
+    if (stmt->getType() == IF_STMT) {
+        return static_cast<IfStatement *>(stmt)->getTarget();
+    }
+    return nullptr;
+}
+
+void TierManager::run(Statement *first, EvalState &state, Program &program) {
+    loops.clear(); // 上次 RUN 的语句可能已经删掉了
+    promotions = 0;
+    Statement *stmt = first;
+    while (stmt != nullptr) {
+        stmt->AddTimes();
+        Statement *next = stmt->execute(state, program);
+        if (next != nullptr && next != stmt->getNext() && next->getLineNumber() <= stmt->getLineNumber()) {
+            Loop &loop = loops[stmt]; // 走了一次向后的跳转
+            if (++loop.taken == HOT_BRANCH) {
+                loop.promoted = findExits(next, stmt, loop.exits);
+            }
+            if (loop.promoted) {
+                ++promotions;
+                next = program.getBytecode().run(next, state, loop.exits);
+            }
+        }
+        stmt = next;
+    }
+}
+
+int TierManager::getPromotions() const {
+    return promotions;
+}
+
+/*
+ * Implementation notes: findExits
+ * -------------------------------
+ * The loop is the run of lines from the head (the branch target) to
+ * the branch.  Control leaves it by a GOTO or IF to a line outside
+ * that range, or by falling through after the branch.  All of those
+ * lead to leaders, since branch targets and the lines after a branch
+ * lead basic blocks.
+ */
+
+bool TierManager::findExits(Statement *head, Statement *branch, std::vector<Statement *> &exits) {
+    if (head->getBlock() < 0) {
+        return false;
+    }
+    const int low = head->getLineNumber();
+    const int high = branch->getLineNumber();
+    exits.clear();
+    for (Statement *stmt = head; stmt != nullptr; stmt = stmt->getNext()) {
+        Statement *target = targetOf(stmt);
+        if (target != nullptr && (target->getLineNumber() < low || target->getLineNumber() > high)) {
+            exits.push_back(target);
+        }
+        if (stmt == branch) {
+            if (stmt->getNext() != nullptr) {
+                exits.push_back(stmt->getNext());
+            }
+            break;
+        }
+    }
+    std::sort(exits.begin(), exits.end());
+    exits.erase(std::unique(exits.begin(), exits.end()), exits.end());
+    for (Statement *exit : exits) {
+        if (exit->getBlock() < 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+ * File: tier.h
+ * ------------
+ * This interface exports the tiering manager used by RUN when the
+ * interpreter is started with --tiered.  A program starts out in the
+ * tree-walking loop, which costs nothing to enter, and hot loops are
+ * moved to the compiled bytecode while the program is running.
+ */
+
+#ifndef _tier_h
+#define _tier_h
+
+#include <unordered_map>
+#include <vector>
+#include "evalstate.hpp"
+
+class Program;
+class Statement;
+
+/*
+ * Class: TierManager
+ * ------------------
+ * Runs a program in the tree-walking loop and counts how often each
+ * backward branch (a GOTO or IF whose target line is not after its
+ * own line) is taken.  Once a branch has been taken HOT_BRANCH times
+ * in a RUN, the loop it closes is promoted: the next time the branch
+ * is taken, execution continues in the bytecode tier at the target,
+ * without restarting the RUN, and comes back to the tree-walking loop
+ * when control leaves the loop.  Both tiers work on the same
+ * EvalState and the same execution counters, so nothing needs to be
+ * converted at the transfer.
+ */
+
+class TierManager {
+
+public:
+
+/*
+ * Constant: HOT_BRANCH
+ * --------------------
+ * The number of times a backward branch must be taken before its loop
+ * is promoted.  A statement can only run 999 times in all, so loops
+ * are promoted early.
+ */
+
+    static const int HOT_BRANCH = 16;
+
+    TierManager();
+
+/*
+ * Method: run
+ * Usage: tiers.run(first, state, program);
+ * ----------------------------------------
+ * Runs the linked program from its first statement until it ends or
+ * an error is raised.
+ */
+
+    void run(Statement *first, EvalState &state, Program &program);
+
+/*
+ * Method: getPromotions
+ * Usage: int count = tiers.getPromotions();
+ * -----------------------------------------
+ * Returns how many times the last RUN entered the bytecode tier.
+ */
+
+    int getPromotions() const;
+
+private:
+
+/*
+ * Type: Loop
+ * ----------
+ * What is known about one backward branch: how often it was taken in
+ * this RUN and, once it is hot, the leaders just outside the loop at
+ * which the bytecode tier hands control back.
+ */
+
+    struct Loop {
+        int taken;
+        bool promoted;
+        std::vector<Statement *> exits;
+    };
+
+    std::unordered_map<Statement *, Loop> loops; // 向后跳转语句 -> 统计
+    int promotions;
+
+    bool findExits(Statement *head, Statement *branch, std::vector<Statement *> &exits);
+
+};
+
+#endif
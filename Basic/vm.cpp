@@ -0,0 +1,732 @@
+/*
+ * File: vm.cpp
+ * ------------
+ * This file implements the bytecode compiler and the virtual machine
+ * declared in vm.h.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include "vm.hpp"
+#include "jit.hpp"
+#include "statement.hpp"
+
+
+Bytecode::Bytecode() : version(0), nativeVersion(0) {
+    clear();
+}
+
+Bytecode::~Bytecode() = default;
+
+void Bytecode::clear() {
+    ++version;
+    code.clear();
+    messages.clear();
+    blocks.clear();
+    activeBlocks.clear();
+    exitBlocks.clear();
+    fragments.clear();
+    fixups.clear();
+    trap = -1;
+    depth = 0;
+    maxDepth = 0;
+    emit(OP_HALT); // 地址 0 固定是 HALT，跳到不存在的行时用
+    deadSize = 0;
+}
+
+/*
+ * Implementation notes: compile
+ * -----------------------------
+ * A statement's fragment is the body, preceded by OP_BLOCK if the
+ * statement is a leader, followed by the jump to the next statement
+ * unless the body always leaves (GOTO, END) or the next fragment
+ * follows directly.  An IF whose target line is missing jumps to
+ * address 0, which halts, because taking such a branch ends the RUN
+ * without a message.  A fragment is never empty: a REM that is not a
+ * leader keeps its jump even when the next fragment follows, since
+ * two fragments must not share an entry address.
+ */
+
+void Bytecode::compile(Statement *stmt, bool fallsThrough, bool leader) {
+    ++version;
+    const int entry = int(code.size());
+    const bool redirected = stmt->getCodeEntry() >= 0;
+    if (redirected) { // 旧的片段改成跳到新片段
+        code[stmt->getCodeEntry()] = {OP_JUMP, entry};
+    }
+    stmt->setCodeEntry(entry);
+    fragments.emplace_back(entry, stmt);
+    if (leader) {
+        stmt->setBlock(int(blocks.size()));
+        blocks.push_back({stmt, 0, 0, false, false});
+        emit(OP_BLOCK, stmt->getBlock());
+    } else {
+        stmt->setBlock(-1);
+    }
+
+    bool leaves = false; // GOTO 和 END 不会走到下一行
+    if (!compileFused(stmt)) { // 不能融合的语句按一般方式编译
+        switch (stmt->getType()) {
+            case LET_STMT: {
+                const auto *let = static_cast<LetStatement *>(stmt);
+                compileExp(let->getExp());
+                emit(OP_STORE, let->getSlot());
+                break;
+            }
+            case PRINT_STMT:
+                compileExp(static_cast<PrintStatement *>(stmt)->getExp());
+                emit(OP_PRINT);
+                break;
+            case INPUT_STMT:
+                emit(OP_INPUT, static_cast<InputStatement *>(stmt)->getSlot());
+                break;
+            case REM_STMT:
+                break;
+            case GOTO_STMT: {
+                const auto *gotoStmt = static_cast<GotoStatement *>(stmt);
+                if (gotoStmt->getTarget() != nullptr) {
+                    emitJump(OP_JUMP, gotoStmt->getTarget());
+                } else {
+                    emit(OP_MISSING_LINE);
+                }
+                leaves = true;
+                break;
+            }
+            case IF_STMT: {
+                const auto *ifStmt = static_cast<IfStatement *>(stmt);
+                compileExp(ifStmt->getLHS());
+                compileExp(ifStmt->getRHS());
+                const TokenKind relation = ifStmt->getRelation();
+                const OpCode jump = relation == EQUALS_TOKEN ? OP_JUMP_EQ : relation == LESS_TOKEN ? OP_JUMP_LT : OP_JUMP_GT;
+                if (ifStmt->getTarget() != nullptr) {
+                    emitJump(jump, ifStmt->getTarget());
+                } else {
+                    emit(jump, 0);
+                }
+                break;
+            }
+            case END_STMT:
+                emit(OP_HALT);
+                leaves = true;
+                break;
+        }
+    }
+
+    depth = 0;
+
+    if (!leaves) {
+        if (stmt->getNext() == nullptr) {
+            emit(OP_HALT);
+        } else if (!fallsThrough || int(code.size()) == entry) { // 片段不能为空
+            emitJump(OP_JUMP, stmt->getNext());
+        }
+    }
+    if (redirected) {
+        deadSize += code.size() - entry;
+    }
+}
+
+/*
+ * Implementation notes: fusionOf, compileFused
+ * --------------------------------------------
+ * The shapes are matched on the expression tree after constant
+ * folding, so LET x = x + (2 - 1) is still an increment.  A - c is
+ * compiled as an addition of the negated constant, which wraps the
+ * same way as the subtraction.  The superinstructions check their
+ * variables in the same order as the tree-walking evaluator, so
+ * VARIABLE NOT DEFINED and DIVIDE BY ZERO are raised in the same
+ * situations as before.
+ */
+
+static bool isVariable(Expression *exp) {
+    return exp != nullptr && exp->getType() == IDENTIFIER;
+}
+
+static bool isConstant(Expression *exp) {
+    return exp != nullptr && exp->getType() == CONSTANT;
+}
+
+static int variableSlot(Expression *exp) {
+    return ((IdentifierExp *) exp)->getSlot();
+}
+
+static int constantValue(Expression *exp) {
+    return ((ConstantExp *) exp)->getValue();
+}
+
+Fusion Bytecode::fusionOf(Statement *stmt) {
+    if (stmt->getType() == LET_STMT) {
+        Expression *exp = static_cast<LetStatement *>(stmt)->getExp();
+        if (isConstant(exp)) return FUSE_SET_CONST;
+        if (isVariable(exp)) return FUSE_COPY;
+        if (exp == nullptr || exp->getType() != COMPOUND) return NOT_FUSED;
+        auto *compound = (CompoundExp *) exp;
+        const std::string op = compound->getOp();
+        Expression *lhs = compound->getLHS();
+        Expression *rhs = compound->getRHS();
+        if (op != "+" && op != "-" && op != "*" && op != "/") return NOT_FUSED; // 赋值表达式不融合
+        if (isVariable(lhs) && isVariable(rhs)) return FUSE_BINARY;
+        if (op == "+" && ((isVariable(lhs) && isConstant(rhs)) || (isConstant(lhs) && isVariable(rhs)))) {
+            return FUSE_ADD_CONST;
+        }
+        if (op == "-" && isVariable(lhs) && isConstant(rhs)) return FUSE_ADD_CONST;
+    } else if (stmt->getType() == IF_STMT) {
+        const auto *ifStmt = static_cast<IfStatement *>(stmt);
+        if (isVariable(ifStmt->getLHS()) && isConstant(ifStmt->getRHS())) {
+            return FUSE_BRANCH;
+        }
+    }
+    return NOT_FUSED;
+}
+
+std::string Bytecode::fusionName(Fusion shape) {
+    switch (shape) {
+        case NOT_FUSED:
+            return "not fused";
+        case FUSE_SET_CONST:
+            return "LET v = c";
+        case FUSE_COPY:
+            return "LET v = a";
+        case FUSE_ADD_CONST:
+            return "LET v = a + c";
+        case FUSE_BINARY:
+            return "LET v = a op b";
+        case FUSE_BRANCH:
+            return "IF a op c THEN n";
+        default:
+            return "?";
+    }
+}
+
+bool Bytecode::compileFused(Statement *stmt) {
+    switch (fusionOf(stmt)) {
+        case NOT_FUSED:
+        case FUSION_COUNT:
+            return false;
+        case FUSE_SET_CONST: {
+            const auto *let = static_cast<LetStatement *>(stmt);
+            emit(OP_SET_CONST, let->getSlot());
+            emit(OP_HALT, constantValue(let->getExp()));
+            break;
+        }
+        case FUSE_COPY: {
+            const auto *let = static_cast<LetStatement *>(stmt);
+            emit(OP_COPY, let->getSlot());
+            emit(OP_HALT, variableSlot(let->getExp()));
+            break;
+        }
+        case FUSE_ADD_CONST: {
+            const auto *let = static_cast<LetStatement *>(stmt);
+            auto *compound = (CompoundExp *) let->getExp();
+            Expression *lhs = compound->getLHS();
+            Expression *rhs = compound->getRHS();
+            if (isConstant(lhs)) std::swap(lhs, rhs); // c + a 和 a + c 一样
+            int c = constantValue(rhs);
+            if (compound->getOp() == "-") c = int(0u - unsigned(c));
+            emit(OP_ADD_CONST, let->getSlot());
+            emit(OP_HALT, variableSlot(lhs));
+            emit(OP_HALT, c);
+            break;
+        }
+        case FUSE_BINARY: {
+            const auto *let = static_cast<LetStatement *>(stmt);
+            auto *compound = (CompoundExp *) let->getExp();
+            const std::string op = compound->getOp();
+            emit(op == "+" ? OP_SET_ADD : op == "-" ? OP_SET_SUB : op == "*" ? OP_SET_MUL : OP_SET_DIV, let->getSlot());
+            emit(OP_HALT, variableSlot(compound->getLHS()));
+            emit(OP_HALT, variableSlot(compound->getRHS()));
+            break;
+        }
+        case FUSE_BRANCH: {
+            const auto *ifStmt = static_cast<IfStatement *>(stmt);
+            const TokenKind relation = ifStmt->getRelation();
+            emit(relation == EQUALS_TOKEN ? OP_JUMP_EQ_CONST : relation == LESS_TOKEN ? OP_JUMP_LT_CONST : OP_JUMP_GT_CONST,
+                 variableSlot(ifStmt->getLHS()));
+            emit(OP_HALT, constantValue(ifStmt->getRHS()));
+            if (ifStmt->getTarget() != nullptr) {
+                emitJump(OP_HALT, ifStmt->getTarget());
+            } else {
+                emit(OP_HALT, 0);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+void Bytecode::finish() {
+    for (const auto &fixup : fixups) {
+        code[fixup.first].operand = fixup.second->getCodeEntry();
+    }
+    fixups.clear();
+}
+
+bool Bytecode::needsCompaction() const {
+    return 2 * deadSize > code.size() + 1024;
+}
+
+bool Bytecode::setNative(bool enabled) {
+    if (!enabled || !NativeCode::supported()) {
+        native.reset();
+        return !enabled;
+    }
+    if (native == nullptr) {
+        native.reset(new NativeCode());
+        nativeVersion = 0;
+    }
+    return true;
+}
+
+/*
+ * Implementation notes: run
+ * -------------------------
+ * With native code enabled the program starts there, and run only
+ * takes over when the native code exits: it reports the end of the
+ * program or an error the same way the virtual machine would, or
+ * hands the rest of the RUN to the virtual machine.  If the program
+ * cannot be translated, because the system will not map executable
+ * memory, native code is switched off and the virtual machine runs
+ * the program instead.
+ *
+ * Exit blocks never let a pass through: admit turns them away, so
+ * both the virtual machine and the native code end up in enterBlock,
+ * which stops there.  settle clears the marks again.
+ */
+
+Statement *Bytecode::run(Statement *first, EvalState &state, const std::vector<Statement *> &exits) {
+    if (native != nullptr && nativeVersion != version) {
+        try {
+            native->translate(*this);
+            nativeVersion = version;
+        } catch (ErrorException &ex) { // 生成不了机器码就退回虚拟机
+            std::cerr << ex.getMessage() << ", using the interpreter" << std::endl;
+            native.reset();
+        }
+    }
+    for (Statement *exit : exits) {
+        blocks[exit->getBlock()].exit = true;
+        exitBlocks.push_back(exit->getBlock());
+    }
+    int pc = first->getCodeEntry();
+    int current = -1;
+    if (native != nullptr) {
+        const NativeCode::Status status = native->run(pc, state, current);
+        if (status == NativeCode::EXIT_HALT || status == NativeCode::EXIT_MISSING_LINE) {
+            if (status == NativeCode::EXIT_MISSING_LINE) {
+                std::cout << "LINE NUMBER ERROR" << std::endl;
+            }
+            settle(-1, 0);
+            return nullptr;
+        }
+        if (status != NativeCode::EXIT_RESUME) {
+            settle(current, pc);
+            error(status == NativeCode::EXIT_UNDEFINED ? "VARIABLE NOT DEFINED"
+                  : status == NativeCode::EXIT_DIVIDE ? "DIVIDE BY ZERO" : messages[code[pc].operand]);
+        }
+    }
+    return execute(pc, current, state);
+}
+
+/*
+ * Implementation notes: execute
+ * -----------------------------
+ * The dispatch loop keeps the instruction and stack pointers in
+ * local variables.  Errors are raised with error() exactly where
+ * the tree-walking evaluator raises them, so the partial effects of
+ * a failing RUN (variables already assigned, lines already counted)
+ * are the same in both modes.  For the counters that takes a little
+ * help: when an error escapes, settle is told which block was being
+ * executed and where, so that the statements after the failing one
+ * are not credited with the last pass.
+ *
+ * The loop is written once with the CASE and NEXT macros and built
+ * in one of two ways.  With BASIC_THREADED_DISPATCH and a GCC-style
+ * compiler every handler ends in its own indirect jump through a
+ * table of label addresses (direct threading), which gives the
+ * branch predictor one history per handler instead of a single
+ * shared switch jump.  Otherwise it is an ordinary switch.
+ */
+
+static inline int loadVariable(EvalState &state, int slot) {
+    if (!state.isDefined(slot)) error("VARIABLE NOT DEFINED");
+    return state.getValue(slot);
+}
+
+#if defined(BASIC_THREADED_DISPATCH) && BASIC_THREADED_DISPATCH && defined(__GNUC__)
+#define THREADED_DISPATCH 1
+#define CASE(op) L_##op:
+#define NEXT in = ip++; goto *dispatch[in->op]
+#else
+#define THREADED_DISPATCH 0
+#define CASE(op) case op:
+#define NEXT break
+#endif
+
+Statement *Bytecode::execute(int pc, int current, EvalState &state) {
+    std::vector<int> stack(maxDepth + 1);
+    int *sp = stack.data();
+    const Instruction *base = code.data();
+    const Instruction *ip = base + pc;
+    const Instruction *in = ip;
+    try {
+#if THREADED_DISPATCH
+    static void *const dispatch[] = {
+            &&L_OP_HALT, &&L_OP_BLOCK, &&L_OP_CONST, &&L_OP_LOAD, &&L_OP_STORE, &&L_OP_ASSIGN,
+            &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_DROP2_ZERO, &&L_OP_PRINT,
+            &&L_OP_INPUT, &&L_OP_JUMP, &&L_OP_JUMP_EQ, &&L_OP_JUMP_LT, &&L_OP_JUMP_GT,
+            &&L_OP_MISSING_LINE, &&L_OP_FAIL, &&L_OP_TRAP, &&L_OP_SET_CONST, &&L_OP_COPY, &&L_OP_ADD_CONST,
+            &&L_OP_SET_ADD, &&L_OP_SET_SUB, &&L_OP_SET_MUL, &&L_OP_SET_DIV, &&L_OP_JUMP_EQ_CONST,
+            &&L_OP_JUMP_LT_CONST, &&L_OP_JUMP_GT_CONST
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == OP_JUMP_GT_CONST + 1, "dispatch table out of date");
+    NEXT;
+#else
+    while (true) {
+        in = ip++;
+        switch (in->op) {
+#endif
+            CASE(OP_HALT)
+                settle(-1, 0);
+                return nullptr;
+            CASE(OP_BLOCK) {
+                current = in->operand;
+                Block &block = blocks[current];
+                if (block.entries < block.headroom) {
+                    ++block.entries;
+                } else if (!enterBlock(current)) { // 出口块，交还给调用者
+                    settle(-1, 0);
+                    return block.leader;
+                }
+                NEXT;
+            }
+            CASE(OP_CONST)
+                *sp++ = in->operand;
+                NEXT;
+            CASE(OP_LOAD)
+                *sp++ = loadVariable(state, in->operand);
+                NEXT;
+            CASE(OP_STORE)
+                state.setValue(in->operand, *--sp);
+                NEXT;
+            CASE(OP_ASSIGN)
+                state.setValue(in->operand, sp[-1]);
+                NEXT;
+            CASE(OP_ADD)
+                --sp;
+                sp[-1] = sp[-1] + sp[0];
+                NEXT;
+            CASE(OP_SUB)
+                --sp;
+                sp[-1] = sp[-1] - sp[0];
+                NEXT;
+            CASE(OP_MUL)
+                --sp;
+                sp[-1] = sp[-1] * sp[0];
+                NEXT;
+            CASE(OP_DIV)
+                --sp;
+                if (sp[0] == 0) error("DIVIDE BY ZERO");
+                sp[-1] = sp[-1] / sp[0];
+                NEXT;
+            CASE(OP_DROP2_ZERO)
+                --sp;
+                sp[-1] = 0;
+                NEXT;
+            CASE(OP_PRINT)
+                std::cout << *--sp << std::endl;
+                NEXT;
+            CASE(OP_INPUT)
+                state.setValue(in->operand, InputStatement::readValue());
+                NEXT;
+            CASE(OP_JUMP)
+                ip = base + in->operand;
+                NEXT;
+            CASE(OP_JUMP_EQ)
+                sp -= 2;
+                if (sp[0] == sp[1]) ip = base + in->operand;
+                NEXT;
+            CASE(OP_JUMP_LT)
+                sp -= 2;
+                if (sp[0] < sp[1]) ip = base + in->operand;
+                NEXT;
+            CASE(OP_JUMP_GT)
+                sp -= 2;
+                if (sp[0] > sp[1]) ip = base + in->operand;
+                NEXT;
+            CASE(OP_MISSING_LINE)
+                std::cout << "LINE NUMBER ERROR" << std::endl;
+                settle(-1, 0);
+                return nullptr;
+            CASE(OP_FAIL)
+                error(messages[in->operand]);
+                NEXT;
+            CASE(OP_TRAP)
+                error("SYNTAX ERROR");
+                NEXT;
+            CASE(OP_SET_CONST)
+                state.setValue(in->operand, ip[0].operand);
+                ip += 1;
+                NEXT;
+            CASE(OP_COPY)
+                state.setValue(in->operand, loadVariable(state, ip[0].operand));
+                ip += 1;
+                NEXT;
+            CASE(OP_ADD_CONST)
+                state.setValue(in->operand, loadVariable(state, ip[0].operand) + ip[1].operand);
+                ip += 2;
+                NEXT;
+            CASE(OP_SET_ADD) {
+                const int a = loadVariable(state, ip[0].operand);
+                state.setValue(in->operand, a + loadVariable(state, ip[1].operand));
+                ip += 2;
+                NEXT;
+            }
+            CASE(OP_SET_SUB) {
+                const int a = loadVariable(state, ip[0].operand);
+                state.setValue(in->operand, a - loadVariable(state, ip[1].operand));
+                ip += 2;
+                NEXT;
+            }
+            CASE(OP_SET_MUL) {
+                const int a = loadVariable(state, ip[0].operand);
+                state.setValue(in->operand, a * loadVariable(state, ip[1].operand));
+                ip += 2;
+                NEXT;
+            }
+            CASE(OP_SET_DIV) {
+                const int a = loadVariable(state, ip[0].operand);
+                const int b = loadVariable(state, ip[1].operand);
+                if (b == 0) error("DIVIDE BY ZERO");
+                state.setValue(in->operand, a / b);
+                ip += 2;
+                NEXT;
+            }
+            CASE(OP_JUMP_EQ_CONST)
+                ip = loadVariable(state, in->operand) == ip[0].operand ? base + ip[1].operand : ip + 2;
+                NEXT;
+            CASE(OP_JUMP_LT_CONST)
+                ip = loadVariable(state, in->operand) < ip[0].operand ? base + ip[1].operand : ip + 2;
+                NEXT;
+            CASE(OP_JUMP_GT_CONST)
+                ip = loadVariable(state, in->operand) > ip[0].operand ? base + ip[1].operand : ip + 2;
+                NEXT;
+#if !THREADED_DISPATCH
+        }
+    }
+#endif
+    } catch (...) {
+        settle(current, int(in - base));
+        throw;
+    }
+}
+
+#undef CASE
+#undef NEXT
+
+/*
+ * Implementation notes: admit, enterBlock
+ * ---------------------------------------
+ * The slow path of OP_BLOCK.  On the first pass through a block in a
+ * RUN, admit works out the headroom from the largest counter in the
+ * block: a statement that has run n times may run 999 - n more times
+ * without an error.  It counts the pass if there is headroom left and
+ * never raises an error, so native code can call it.
+ *
+ * When the headroom is used up, enterBlock credits the passes so far,
+ * and the statement that reaches the limit first on
+ * this pass is the first one whose counter is at 999.  If that is the
+ * leader the error is raised right away; otherwise an OP_TRAP is
+ * planted on its fragment, so that the statements before it still
+ * run, and settle puts the original instruction back.  enterBlock
+ * returns false only for an exit block.
+ */
+
+bool Bytecode::admit(int index) {
+    Block &block = blocks[index];
+    if (block.exit) {
+        return false;
+    }
+    if (!block.active) {
+        uint64_t most = 0;
+        Statement *stmt = block.leader;
+        do {
+            most = std::max(most, stmt->getExecutionCount());
+            stmt = stmt->getNext();
+        } while (stmt != nullptr && stmt->getBlock() < 0);
+        block.active = true;
+        block.entries = 0;
+        block.headroom = most < 999 ? 999 - most : 0;
+        activeBlocks.push_back(index);
+    }
+    if (block.entries < block.headroom) {
+        ++block.entries;
+        return true;
+    }
+    return false;
+}
+
+bool Bytecode::enterBlock(int index) {
+    if (admit(index)) {
+        return true;
+    }
+    Block &block = blocks[index];
+    if (block.exit) {
+        return false;
+    }
+    // 这一遍会有语句执行到第 1000 次
+    credit(block, block.entries, nullptr);
+    block.entries = 1;
+    block.headroom = 0;
+    Statement *limit = block.leader;
+    while (limit->getExecutionCount() < 999) {
+        limit = limit->getNext();
+    }
+    if (limit == block.leader) {
+        error("SYNTAX ERROR");
+    }
+    trap = limit->getCodeEntry();
+    trapped = code[trap];
+    code[trap] = {OP_TRAP, 0};
+    return true;
+}
+
+/*
+ * Implementation notes: settle
+ * ----------------------------
+ * Called whenever run stops.  Every block entered during the RUN has
+ * its passes credited to its statements, and the exit marks are
+ * removed.  If an error stopped the RUN inside failedBlock, the pass
+ * in progress only counts for the statements up to and including the
+ * one that failed, which is found from the address of the failing
+ * instruction.
+ */
+
+void Bytecode::settle(int failedBlock, int pc) {
+    if (trap >= 0) {
+        code[trap] = trapped;
+        trap = -1;
+    }
+    for (int index : activeBlocks) {
+        Block &block = blocks[index];
+        if (index == failedBlock && block.entries > 0) {
+            credit(block, block.entries - 1, statementAt(pc));
+        } else {
+            credit(block, block.entries, nullptr);
+        }
+        block.entries = 0;
+        block.headroom = 0;
+        block.active = false;
+    }
+    activeBlocks.clear();
+    for (int index : exitBlocks) {
+        blocks[index].exit = false;
+    }
+    exitBlocks.clear();
+}
+
+/*
+ * Implementation notes: credit
+ * ----------------------------
+ * Adds passes executions to every statement of the block.  If failed
+ * is not NULL, the statements from the leader up to failed get one
+ * more, for the pass that stopped there.
+ */
+
+void Bytecode::credit(const Block &block, uint64_t passes, Statement *failed) {
+    uint64_t extra = failed != nullptr ? 1 : 0;
+    Statement *stmt = block.leader;
+    do {
+        stmt->addExecutions(passes + extra);
+        if (stmt == failed) {
+            extra = 0;
+        }
+        stmt = stmt->getNext();
+    } while (stmt != nullptr && stmt->getBlock() < 0);
+}
+
+/*
+ * Implementation notes: statementAt
+ * ---------------------------------
+ * Fragments are appended in address order, so the statement whose
+ * code contains pc is the last fragment that starts at or before it.
+ * Fragments that were redirected are never executed past their first
+ * instruction, so the answer is always a live statement.
+ */
+
+Statement *Bytecode::statementAt(int pc) const {
+    auto it = std::upper_bound(fragments.begin(), fragments.end(), pc,
+                               [](int address, const std::pair<int, Statement *> &fragment) {
+                                   return address < fragment.first;
+                               });
+    return it == fragments.begin() ? nullptr : std::prev(it)->second;
+}
+
+void Bytecode::emit(OpCode op, int operand) {
+    code.push_back({op, operand});
+}
+
+void Bytecode::emitJump(OpCode op, Statement *target) {
+    fixups.emplace_back(int(code.size()), target);
+    emit(op, 0);
+}
+
+/*
+ * Implementation notes: compileExp
+ * --------------------------------
+ * Expressions are compiled in post-order, which evaluates operands
+ * in the same order as CompoundExp::eval.  An assignment whose left
+ * side is not a plain variable compiles to OP_FAIL with the message
+ * eval would raise; the stack depth is counted as if it had pushed
+ * its value, since nothing after it runs.
+ */
+
+void Bytecode::compileExp(Expression *exp) {
+    switch (exp->getType()) {
+        case CONSTANT:
+            emit(OP_CONST, ((ConstantExp *) exp)->getValue());
+            break;
+        case IDENTIFIER:
+            emit(OP_LOAD, ((IdentifierExp *) exp)->getSlot());
+            break;
+        case COMPOUND: {
+            auto *compound = (CompoundExp *) exp;
+            const std::string op = compound->getOp();
+            Expression *lhs = compound->getLHS();
+            if (op == "=") {
+                if (lhs->getType() != IDENTIFIER) {
+                    emit(OP_FAIL, messageIndex("Illegal variable in assignment"));
+                } else if (lhs->toString() == "LET") {
+                    emit(OP_FAIL, messageIndex("SYNTAX ERROR"));
+                } else {
+                    compileExp(compound->getRHS());
+                    emit(OP_ASSIGN, ((IdentifierExp *) lhs)->getSlot());
+                    return;
+                }
+                break;
+            }
+            compileExp(lhs);
+            compileExp(compound->getRHS());
+            if (op == "+") emit(OP_ADD);
+            else if (op == "-") emit(OP_SUB);
+            else if (op == "*") emit(OP_MUL);
+            else if (op == "/") emit(OP_DIV);
+            else emit(OP_DROP2_ZERO);
+            depth -= 2; // 弹出两个操作数，下面再压入结果
+            break;
+        }
+    }
+    if (++depth > maxDepth) {
+        maxDepth = depth;
+    }
+}
+
+int Bytecode::messageIndex(const std::string &message) {
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        if (messages[i] == message) {
+            return int(i);
+        }
+    }
+    messages.push_back(message);
+    return int(messages.size()) - 1;
+}
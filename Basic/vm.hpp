@@ -0,0 +1,293 @@
+/*
+ * File: vm.h
+ * ----------
+ * This interface exports the bytecode form of a BASIC program and
+ * the stack machine that executes it.  RUN compiles the linked
+ * statements into one array of instructions and hands it to the
+ * virtual machine, instead of walking the statement and expression
+ * trees line by line.
+ */
+
+#ifndef _vm_h
+#define _vm_h
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Statement;
+class Expression;
+class EvalState;
+class NativeCode;
+
+/*
+ * Type: OpCode
+ * ------------
+ * The instructions understood by the virtual machine.  Expressions
+ * are evaluated on an operand stack; the comments give the effect
+ * of each instruction on that stack.
+ */
+
+enum OpCode : unsigned char {
+    OP_HALT,          // stop the program
+    OP_BLOCK,         // enter basic block operand
+    OP_CONST,         // push operand
+    OP_LOAD,          // push the value of the variable in slot operand
+    OP_STORE,         // pop a value into the variable in slot operand
+    OP_ASSIGN,        // store the top of stack into slot operand, keep it
+    OP_ADD,           // a b -> a + b
+    OP_SUB,           // a b -> a - b
+    OP_MUL,           // a b -> a * b
+    OP_DIV,           // a b -> a / b
+    OP_DROP2_ZERO,    // a b -> 0
+    OP_PRINT,         // pop and print a value
+    OP_INPUT,         // read a value into the variable in slot operand
+    OP_JUMP,          // continue at operand
+    OP_JUMP_EQ,       // a b -> ; continue at operand if a = b
+    OP_JUMP_LT,       // a b -> ; continue at operand if a < b
+    OP_JUMP_GT,       // a b -> ; continue at operand if a > b
+    OP_MISSING_LINE,  // a GOTO whose target line does not exist
+    OP_FAIL,          // raise the error message operand
+    OP_TRAP,          // a statement about to run for the 1000th time
+
+    /* Superinstructions: one whole statement each, stack untouched */
+
+    OP_SET_CONST,     // v = c                   operands v, c
+    OP_COPY,          // v = a                   operands v, a
+    OP_ADD_CONST,     // v = a + c               operands v, a, c
+    OP_SET_ADD,       // v = a + b               operands v, a, b
+    OP_SET_SUB,       // v = a - b               operands v, a, b
+    OP_SET_MUL,       // v = a * b               operands v, a, b
+    OP_SET_DIV,       // v = a / b               operands v, a, b
+    OP_JUMP_EQ_CONST, // if a = c continue at t  operands a, c, t
+    OP_JUMP_LT_CONST, // if a < c continue at t  operands a, c, t
+    OP_JUMP_GT_CONST  // if a > c continue at t  operands a, c, t
+};
+
+/*
+ * Type: Fusion
+ * ------------
+ * The statement shapes that compile to a single superinstruction,
+ * where v, a and b stand for variables and c for a constant.
+ * Bytecode::fusionOf tells which one, if any, a statement has.
+ */
+
+enum Fusion {
+    NOT_FUSED,
+    FUSE_SET_CONST,   // LET v = c
+    FUSE_COPY,        // LET v = a
+    FUSE_ADD_CONST,   // LET v = a + c, LET v = c + a, LET v = a - c
+    FUSE_BINARY,      // LET v = a op b
+    FUSE_BRANCH,      // IF a op c THEN n
+    FUSION_COUNT
+};
+
+/*
+ * Type: Instruction
+ * -----------------
+ * A single instruction: an opcode and one integer operand, whose
+ * meaning depends on the opcode (a constant, a variable slot, a code
+ * address, a statement or a message index).
+ *
+ * Superinstructions need more than one operand.  The first is stored
+ * in the instruction itself and the others in the instructions that
+ * immediately follow it, which the handler steps over.  Those extra
+ * words are emitted as OP_HALT and are never dispatched.
+ */
+
+struct Instruction {
+    OpCode op;
+    int operand;
+};
+
+/*
+ * Class: Bytecode
+ * ---------------
+ * This class holds the compiled form of a whole program.  Each
+ * statement is compiled into a fragment that ends by jumping to the
+ * fragment of the statement that follows it.  When a full program is
+ * compiled in line order, the fragments are laid out back to back
+ * and fall through into one another.
+ *
+ * Statements are grouped into basic blocks: a leader, which is the
+ * first line, a branch target or the line after a GOTO, IF or END,
+ * together with the lines that follow it up to the next leader.  Only
+ * a leader's fragment starts with an instruction, OP_BLOCK, that does
+ * the execution accounting, for the whole block at once.  While no
+ * statement of the block can reach the 1000-execution limit, OP_BLOCK
+ * just counts passes through the block; the passes are credited to
+ * the statements when the RUN ends, so the counters seen between RUNs
+ * are exactly those of the tree-walking loop.  A pass that will reach
+ * the limit plants an OP_TRAP on the statement that reaches it first.
+ *
+ * After an edit only the statements whose links changed are compiled
+ * again.  Their new fragments are appended to the code and the first
+ * instruction of the old fragment is overwritten with a jump to the
+ * new one, so any code that still refers to the old address follows
+ * the jump.  Once enough dead code has piled up, needsCompaction
+ * asks for a fresh compilation.
+ */
+
+class Bytecode {
+
+public:
+
+    Bytecode();
+    ~Bytecode();
+
+/*
+ * Method: clear
+ * Usage: code.clear();
+ * --------------------
+ * Discards all compiled code.
+ */
+
+    void clear();
+
+/*
+ * Method: compile
+ * Usage: code.compile(stmt, fallsThrough, leader);
+ * ------------------------------------------------
+ * Appends the fragment for a linked statement.  If the statement was
+ * compiled before, its old fragment is redirected to the new one;
+ * callers starting over after clear must reset the code entry of
+ * every statement to -1 first.
+ * When fallsThrough is true the caller promises to compile the
+ * statement's successor immediately afterwards, so no jump to it is
+ * emitted.  Branch addresses are filled in by finish.
+ * The leader flag says whether the statement starts a basic block.
+ * It may be set on statements that need not start one, but every
+ * statement that can be reached other than from the line before it,
+ * or that follows a GOTO, IF or END, must be compiled as a leader.
+ */
+
+    void compile(Statement *stmt, bool fallsThrough, bool leader);
+
+/*
+ * Method: finish
+ * Usage: code.finish();
+ * ---------------------
+ * Resolves the jumps emitted by the preceding calls to compile.
+ * Every statement they refer to must have been compiled by then.
+ */
+
+    void finish();
+
+/*
+ * Method: needsCompaction
+ * Usage: if (code.needsCompaction()) ...
+ * --------------------------------------
+ * Returns true if redirected fragments take up more space than the
+ * live code, in which case the program should be compiled afresh.
+ */
+
+    bool needsCompaction() const;
+
+/*
+ * Method: run
+ * Usage: code.run(first, state);
+ *        Statement *next = code.run(first, state, exits);
+ * -------------------------------------------------------
+ * Executes the program starting at the fragment of the statement
+ * first, which must have been compiled and, unless it is the first
+ * statement of the program, must lead a basic block.  Runtime errors
+ * are raised with error() using the same messages as the
+ * tree-walking evaluator.
+ *
+ * The optional exits are leaders at which execution stops before the
+ * statement runs; run then returns that statement, so the caller can
+ * carry on from there.  Otherwise it returns NULL once the program
+ * has ended.  Counters and variables are up to date either way.
+ */
+
+    Statement *run(Statement *first, EvalState &state, const std::vector<Statement *> &exits = {});
+
+/*
+ * Method: setNative
+ * Usage: code.setNative(true);
+ * ----------------------------
+ * Chooses whether run translates the bytecode into native machine
+ * code (see jit.h) before executing it.  The translation is redone
+ * whenever the bytecode has changed since the previous RUN.  Returns
+ * false, leaving the virtual machine in charge, if native code is not
+ * supported on this platform.
+ */
+
+    bool setNative(bool enabled);
+
+/*
+ * Method: fusionOf
+ * Usage: Fusion shape = Bytecode::fusionOf(stmt);
+ * -----------------------------------------------
+ * Returns the superinstruction the compiler selects for stmt, or
+ * NOT_FUSED if the statement is compiled the general way.
+ */
+
+    static Fusion fusionOf(Statement *stmt);
+
+/*
+ * Method: fusionName
+ * Usage: std::string name = Bytecode::fusionName(shape);
+ * ------------------------------------------------------
+ * Returns a readable description of a statement shape, as used in
+ * the --stats histogram.
+ */
+
+    static std::string fusionName(Fusion shape);
+
+private:
+
+/*
+ * Type: Block
+ * -----------
+ * The execution accounting of one basic block.  entries counts the
+ * passes not yet credited to the statements; headroom is how many
+ * passes are allowed before one of them reaches the limit.  Both are
+ * only meaningful while the block is active, that is, between its
+ * first pass in a RUN and the end of that RUN.  An exit block stops
+ * run before its leader executes.
+ */
+
+    struct Block {
+        Statement *leader;
+        uint64_t entries;
+        uint64_t headroom;
+        bool active;
+        bool exit;
+    };
+
+    std::vector<Instruction> code;
+    std::vector<std::string> messages; // OP_FAIL 的报错信息
+    std::vector<Block> blocks; // OP_BLOCK 的操作数是下标
+    std::vector<int> activeBlocks; // 本次 RUN 进入过的基本块
+    std::vector<int> exitBlocks; // 本次 run 到这些块就返回
+    std::vector<std::pair<int, Statement *>> fragments; // 每个片段的入口地址，按地址递增
+    std::vector<std::pair<int, Statement *>> fixups; // 待回填的跳转
+    int trap; // 放了 OP_TRAP 的地址，没有时为 -1
+    Instruction trapped; // 被 OP_TRAP 盖掉的指令
+    std::size_t deadSize; // 被新片段取代的旧片段的大致长度
+    int depth; // 编译表达式时的栈深度
+    int maxDepth;
+    std::unique_ptr<NativeCode> native; // --jit 时的机器码，否则为空
+    uint64_t version; // 每次改动字节码加一
+    uint64_t nativeVersion; // 机器码翻译自哪个版本
+
+    friend class NativeCode;
+
+    Statement *execute(int pc, int current, EvalState &state);
+    bool admit(int index);
+    bool enterBlock(int index);
+    void settle(int failedBlock, int pc);
+    void credit(const Block &block, uint64_t passes, Statement *failed);
+    Statement *statementAt(int pc) const;
+    void emit(OpCode op, int operand = 0);
+    void emitJump(OpCode op, Statement *target);
+    void compileExp(Expression *exp);
+    bool compileFused(Statement *stmt);
+    int messageIndex(const std::string &message);
+
+};
+
+#endif
@@ -0,0 +1,673 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Benchmark driver for the BASIC interpreter.
+ *
+ * Each scenario generates BASIC sessions of growing size, feeds them to
+ * the interpreter on stdin and reports the wall-clock time.  With -b the
+ * same sessions are also fed to a second executable (for example a build
+ * of an older revision) so that the two columns can be compared directly.
+ *
+ * Build the interpreter in release mode first:
+ *
+ *     cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build
+ *     g++ -std=c++17 -O2 -o bench bench.cpp
+ *     ./bench -e build/code
+ *
+ * To compare the two ways of dispatching bytecode, build a second copy
+ * with -DBASIC_THREADED_DISPATCH=OFF and pass it as the baseline:
+ *
+ *     cmake -S . -B build-switch -DCMAKE_BUILD_TYPE=Release -DBASIC_THREADED_DISPATCH=OFF
+ *     cmake --build build-switch
+ *     ./bench -e build/code -b build-switch/code -s loop
+ *
+ * Flags for the baseline go in -g, e.g. to compare the tree-walking loop
+ * against an older build's:
+ *
+ *     ./bench -e build/code -f --tree-walk -b old/code -g --tree-walk -s steps
+ *
+ * The same build serves as its own baseline to compare native code with
+ * the bytecode interpreter:
+ *
+ *     ./bench -e build/code -f --jit -b build/code -s straight
+ *
+ * or tiered execution with the tree-walking loop it starts from:
+ *
+ *     ./bench -e build/code -f --tiered -b build/code -g --tree-walk -s steps
+ *
+ * and closure-compiled expressions with Expression::eval:
+ *
+ *     ./bench -e build/code -f --closures -b build/code -g --tree-walk -s expr
+ *
+ * and the same for the flat expression pool:
+ *
+ *     ./bench -e build/code -f --flat -b build/code -g --tree-walk -s expr
+ *
+ * LOAD parses on one thread per core; to see how it scales, compare
+ * a thread count with a single thread:
+ *
+ *     ./bench -e build/code -f "--threads 4" -b build/code -g "--threads 1" -s bulkload
+ *
+ * With -m every workload is run once more to collect the allocation
+ * report that a build configured with -DBASIC_COUNT_ALLOCATIONS=ON
+ * prints when it exits, for example while loading a large program:
+ *
+ *     cmake -S . -B build-count -DCMAKE_BUILD_TYPE=Release -DBASIC_COUNT_ALLOCATIONS=ON
+ *     cmake --build build-count
+ *     ./bench -e build-count/code -m -s load
+ */
+
+const string defaultBasic = "./build/code";
+const string inputFile = "bench_input.txt";
+const string programFile = "bench_program";
+
+string basic = "";
+string baseline = "";
+string scenario = "";
+string extraFlags = "";
+string baselineFlags = "";
+bool allocReports = false;
+
+struct Workload {
+    string label;       // what is varied, e.g. the program size
+    string input;       // the whole session fed to the interpreter
+    long long units;    // work units used for the throughput column
+    string setup;       // if given, timed on its own and subtracted
+};
+
+struct Scenario {
+    string name;
+    string description;
+    string unit;
+    vector<Workload> (*generate)();
+};
+
+void usage(const char *progname) {
+    cout
+            << progname << " [-h] [-e <exec>] [-b <baseline_exec>] [-f <flags>] [-g <flags>] [-s <scenario>] [-m]"
+            << endl
+            << "    -h  Show this message and quit" << endl
+            << "    -e  Interpreter to benchmark, default value: " << defaultBasic << endl
+            << "    -b  Second interpreter to compare against" << endl
+            << "    -f  Extra command-line flags passed to the interpreter under test" << endl
+            << "    -g  Extra command-line flags passed to the baseline interpreter" << endl
+            << "    -s  Run only the named scenario" << endl
+            << "    -m  Show the allocation reports of builds with BASIC_COUNT_ALLOCATIONS" << endl;
+    exit(1);
+}
+
+void parseArguments(int argc, char **argv) {
+    int c;
+    opterr = 0;
+    while ((c = getopt(argc, argv, "e:b:f:g:s:mh")) != -1) {
+        switch (c) {
+            case 'e':
+                basic = optarg;
+                break;
+            case 'b':
+                baseline = optarg;
+                break;
+            case 'f':
+                extraFlags = optarg;
+                break;
+            case 'g':
+                baselineFlags = optarg;
+                break;
+            case 's':
+                scenario = optarg;
+                break;
+            case 'm':
+                allocReports = true;
+                break;
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+    if (basic.size() == 0) basic = defaultBasic;
+}
+
+/*
+ * Scenario: run
+ * -------------
+ * A straight-line program of n lines, each incrementing a counter, is
+ * RUN several times.  Every executed line asks the program for its
+ * successor, so this measures the cost of stepping through the line
+ * index as the program grows.
+ */
+
+vector<Workload> generateRun() {
+    vector<Workload> workloads;
+    const int runs = 5;
+    for (int n : {1000, 2000, 5000, 10000, 20000}) {
+        ostringstream os;
+        os << "1 LET v = 0\n";
+        for (int i = 1; i <= n; i++) os << (i + 1) << " LET v = v + 1\n";
+        os << (n + 2) << " PRINT v\n";
+        for (int r = 0; r < runs; r++) os << "RUN\n";
+        os << "QUIT\n";
+        workloads.push_back({to_string(n) + " lines", os.str(), (long long) (n + 2) * runs, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: edit
+ * --------------
+ * A program of n lines is loaded once, then 1000 single-line edits
+ * (replacements, deletions and insertions, some of them on lines that
+ * GOTOs jump to) are each followed by a RUN.  RUN only executes the first
+ * line, and the same session without the RUNs is subtracted, so what is
+ * left is the cost of bringing the program up to date after an edit.
+ * It should not grow with n.
+ */
+
+vector<Workload> generateEdit() {
+    vector<Workload> workloads;
+    const int edits = 1000;
+    for (int n : {5000, 10000, 20000, 50000}) {
+        ostringstream program;
+        program << "10 END\n";
+        for (int i = 2; i <= n; i++) {
+            if (i % 7 == 0) program << i * 10 << " GOTO " << (i + 50) * 10 << "\n";
+            else program << i * 10 << " LET x = " << i << "\n";
+        }
+        ostringstream os, setup;
+        os << program.str();
+        setup << program.str();
+        unsigned seed = 12345;
+        for (int k = 0; k < edits; k++) {
+            seed = seed * 1103515245 + 12345;
+            int m = 2 + (int) ((seed >> 8) % (n - 1));
+            ostringstream edit;
+            if (k % 500 == 499) edit << "10 END\n"; // the first line runs every time; rewrite it to reset its execution count
+            else if (k % 3 == 0) edit << m * 10 << " LET y = " << k << "\n";
+            else if (k % 3 == 1) edit << m * 10 << "\n";
+            else edit << m * 10 + 5 << " GOTO " << (m + 7) * 10 << "\n";
+            os << edit.str() << "RUN\n";
+            setup << edit.str();
+        }
+        os << "QUIT\n";
+        setup << "QUIT\n";
+        workloads.push_back({to_string(n) + " lines", os.str(), edits, setup.str()});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: loop
+ * --------------
+ * Loop-heavy programs made of k copies of a block that runs Euclid's
+ * algorithm (the loop from Test/trace92.txt) for 30 different inputs.
+ * Each line runs well below the 1000-execution limit, so the amount of
+ * work is set by the number of blocks.  Loading the program is timed
+ * separately and subtracted, leaving the cost of executing the loops.
+ */
+
+long long gcdSteps(int q, int p) {
+    long long steps = 0;
+    while (true) {
+        steps += 4; // LET t, LET q, LET p, IF
+        int t = q - q / p * p;
+        q = p;
+        p = t;
+        if (p <= 0) return steps;
+    }
+}
+
+vector<Workload> generateLoop() {
+    vector<Workload> workloads;
+    const int outer = 30;
+    for (int k : {300, 1000, 2000}) {
+        ostringstream program;
+        long long steps = 0;
+        for (int b = 0; b < k; b++) {
+            int l = (b + 1) * 100;
+            program << l << " LET i = 0\n"
+                    << l + 1 << " LET q = 832040 + i * 7\n"
+                    << l + 2 << " LET p = 514229\n"
+                    << l + 3 << " LET t = q - q / p * p\n"
+                    << l + 4 << " LET q = p\n"
+                    << l + 5 << " LET p = t\n"
+                    << l + 6 << " IF p > 0 THEN " << l + 3 << "\n"
+                    << l + 7 << " LET i = i + 1\n"
+                    << l + 8 << " IF i < " << outer << " THEN " << l + 1 << "\n";
+            steps += 1;
+            for (int i = 0; i < outer; i++) steps += 4 + gcdSteps(832040 + i * 7, 514229);
+        }
+        workloads.push_back({to_string(k) + " blocks", program.str() + "RUN\nQUIT\n", steps,
+                             program.str() + "QUIT\n"});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: steps
+ * ---------------
+ * About a million statement executions spread over blocks of three
+ * lines, a counter and an IF that jumps back to the increment, so each
+ * block stays under the 1000-execution limit.  Nearly all the time goes
+ * into stepping from one statement to the next, which makes this the
+ * scenario to use for the tree-walking loop (-f --tree-walk).  Loading
+ * is timed separately and subtracted.
+ */
+
+vector<Workload> generateSteps() {
+    vector<Workload> workloads;
+    const int bound = 990;
+    for (long long target : {250000LL, 500000LL, 1000000LL}) {
+        ostringstream program;
+        long long steps = 0;
+        for (int l = 10; steps < target; l += 10) {
+            program << l << " LET i = 0\n"
+                    << l + 1 << " LET i = i + 1\n"
+                    << l + 2 << " IF i < " << bound << " THEN " << l + 1 << "\n";
+            steps += 1 + 2LL * bound;
+        }
+        workloads.push_back({to_string(steps) + " steps", program.str() + "RUN\nQUIT\n", steps,
+                             program.str() + "QUIT\n"});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: straight
+ * ------------------
+ * A loop whose body is a long run of k assignments with no branch
+ * between them, executed 990 times.  Almost every step is a line in
+ * the middle of a basic block, so this shows the per-line overhead of
+ * straight-line code.  Loading is timed separately and subtracted.
+ */
+
+vector<Workload> generateStraight() {
+    vector<Workload> workloads;
+    const int iterations = 990;
+    for (int k : {1000, 2000, 5000}) {
+        ostringstream program;
+        program << "1 LET i = 0\n";
+        for (int l = 0; l < k; l++) program << l + 2 << " LET " << (l % 2 ? "a" : "b") << " = i + " << l << "\n";
+        program << k + 2 << " LET i = i + 1\n"
+                << k + 3 << " IF i < " << iterations << " THEN 2\n";
+        workloads.push_back({to_string(k) + " lines", program.str() + "RUN\nQUIT\n",
+                             1 + (long long) (k + 2) * iterations, program.str() + "QUIT\n"});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: expr
+ * --------------
+ * Blocks of a 990-iteration loop whose body evaluates two long
+ * arithmetic expressions, so most of the time goes into evaluating
+ * expressions rather than stepping between lines.  Comparing
+ * -f --closures with -g --tree-walk on the same build measures the
+ * closure-compiled expressions against Expression::eval, and -f --flat
+ * does the same for the flat expression pool.  Loading is timed
+ * separately and subtracted.
+ */
+
+vector<Workload> generateExpr() {
+    vector<Workload> workloads;
+    const int bound = 990;
+    for (int k : {30, 100, 300}) {
+        ostringstream program;
+        program << "1 LET s = 0\n"
+                << "2 LET t = 0\n";
+        for (int b = 0; b < k; b++) {
+            int l = (b + 1) * 10;
+            program << l << " LET i = 0\n"
+                    << l + 1 << " LET s = s + (i * 3 + 7) / 2 - (i - 5) * (i + 1) / 3 + i * i - s / 7\n"
+                    << l + 2 << " LET t = (s - i) * 2 + (t - 1) / 5 - i * (i - 2) / 9\n"
+                    << l + 3 << " LET i = i + 1\n"
+                    << l + 4 << " IF i < " << bound << " THEN " << l + 1 << "\n";
+        }
+        workloads.push_back({to_string(k) + " blocks", program.str() + "RUN\nQUIT\n",
+                             2 + (long long) k * (1 + 4LL * bound), program.str() + "QUIT\n"});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: load
+ * --------------
+ * Loads a program of n lines and quits without running it, so all the
+ * time goes into parsing lines and storing them.  The lines mix the
+ * statement kinds and expression shapes of the other scenarios.  Use
+ * -m to see how many allocations loading takes and how large the heap
+ * grows.
+ */
+
+void generateLoadLine(ostringstream &os, int i) {
+    int l = i * 10;
+    switch (i % 5) {
+        case 0:
+            os << l << " LET x" << i % 97 << " = x" << i % 89 << " + " << i << " * (y - 3)\n";
+            break;
+        case 1:
+            os << l << " IF x" << i % 97 << " < " << i << " THEN " << l + 20 << "\n";
+            break;
+        case 2:
+            os << l << " PRINT (a + b) / 2 - c * " << i << "\n";
+            break;
+        case 3:
+            os << l << " LET i = i + 1\n";
+            break;
+        default:
+            os << l << " GOTO " << l + 10 << "\n";
+            break;
+    }
+}
+
+vector<Workload> generateLoad() {
+    vector<Workload> workloads;
+    for (int n : {10000, 100000}) {
+        ostringstream os;
+        for (int i = 1; i <= n; i++) {
+            generateLoadLine(os, i);
+        }
+        os << "QUIT\n";
+        workloads.push_back({to_string(n) + " lines", os.str(), n, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: scatter
+ * -----------------
+ * The program of load typed in a random order and in descending
+ * order, then LISTed.  Every line but the first lands in the middle
+ * of the program, so this measures inserting lines out of order,
+ * which should cost about as much as typing them in order.
+ */
+
+vector<Workload> generateScatter() {
+    vector<Workload> workloads;
+    for (int n : {10000, 80000}) {
+        vector<string> lines;
+        for (int i = 1; i <= n; i++) {
+            ostringstream line;
+            generateLoadLine(line, i);
+            lines.push_back(line.str());
+        }
+        unsigned seed = 12345;
+        vector<string> shuffled = lines;
+        for (int i = n - 1; i > 0; i--) {
+            seed = seed * 1103515245 + 12345;
+            swap(shuffled[i], shuffled[(seed >> 8) % (i + 1)]);
+        }
+        ostringstream random, descending;
+        for (const string &line : shuffled) random << line;
+        for (int i = n - 1; i >= 0; i--) descending << lines[i];
+        workloads.push_back({to_string(n) + " lines random", random.str() + "LIST\nQUIT\n", n, ""});
+        workloads.push_back({to_string(n) + " lines descending", descending.str() + "LIST\nQUIT\n", n, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: bulkload
+ * ------------------
+ * The program of load, written to a file and read in two ways: typed
+ * line by line on stdin, and with a single LOAD command.  The files
+ * are left in the working directory while the scenario runs and
+ * removed at the end.  With -m the LOADed rows show the resident
+ * memory of a program whose source text stays in the mapped file.
+ */
+
+vector<Workload> generateBulkLoad() {
+    vector<Workload> workloads;
+    for (int n : {100000, 1000000}) {
+        ostringstream os;
+        for (int i = 1; i <= n; i++) {
+            generateLoadLine(os, i);
+        }
+        const string file = programFile + "_" + to_string(n) + ".bas";
+        ofstream out(file);
+        out << os.str();
+        out.close();
+        workloads.push_back({to_string(n) + " lines typed", os.str() + "QUIT\n", n, ""});
+        workloads.push_back({to_string(n) + " lines LOADed", "LOAD \"" + file + "\"\nQUIT\n", n, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: ifload
+ * ----------------
+ * Like load, but every line is an IF statement, with the relational
+ * operators and the shapes of the two sides varied from line to line,
+ * so the time goes into parsing conditions.
+ */
+
+vector<Workload> generateIfLoad() {
+    vector<Workload> workloads;
+    const char relations[] = {'<', '=', '>'};
+    for (int n : {10000, 100000}) {
+        ostringstream os;
+        for (int i = 1; i <= n; i++) {
+            int l = i * 10;
+            os << l << " IF ";
+            switch (i % 4) {
+                case 0:
+                    os << "x" << i % 97;
+                    break;
+                case 1:
+                    os << "x" << i % 97 << " + " << i;
+                    break;
+                case 2:
+                    os << "(a + b) * " << i % 89;
+                    break;
+                default:
+                    os << "i / 2 - c";
+                    break;
+            }
+            os << " " << relations[i % 3] << " ";
+            if (i % 2) os << i;
+            else os << "y" << i % 89 << " * 3";
+            os << " THEN " << (i % 7 ? l + 20 : 10) << "\n";
+        }
+        os << "QUIT\n";
+        workloads.push_back({to_string(n) + " lines", os.str(), n, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: badload
+ * -----------------
+ * Like load, but one line in ten does not parse: a missing
+ * parenthesis, an extra token, a term that cannot start an
+ * expression, a number that is not an integer or a LET without =.
+ * Each of them prints SYNTAX ERROR, so this measures what a paste full
+ * of mistakes costs next to a clean one.
+ */
+
+vector<Workload> generateBadLoad() {
+    vector<Workload> workloads;
+    for (int n : {10000, 100000}) {
+        ostringstream os;
+        for (int i = 1; i <= n; i++) {
+            int l = i * 10;
+            if (i % 10 == 0) {
+                switch (i / 10 % 5) {
+                    case 0:
+                        os << l << " LET x" << i % 97 << " = (y + " << i << " * 2\n";
+                        break;
+                    case 1:
+                        os << l << " PRINT a + b " << i << "\n";
+                        break;
+                    case 2:
+                        os << l << " LET y = * " << i << "\n";
+                        break;
+                    case 3:
+                        os << l << " PRINT " << i << ".5 + c\n";
+                        break;
+                    default:
+                        os << l << " LET z " << i << "\n";
+                        break;
+                }
+                continue;
+            }
+            switch (i % 3) {
+                case 0:
+                    os << l << " LET x" << i % 97 << " = x" << i % 89 << " + " << i << " * (y - 3)\n";
+                    break;
+                case 1:
+                    os << l << " PRINT (a + b) / 2 - c * " << i << "\n";
+                    break;
+                default:
+                    os << l << " IF x" << i % 97 << " < " << i << " THEN " << l + 20 << "\n";
+                    break;
+            }
+        }
+        os << "QUIT\n";
+        workloads.push_back({to_string(n) + " lines", os.str(), n, ""});
+    }
+    return workloads;
+}
+
+/*
+ * Scenario: parse
+ * ---------------
+ * A corpus of n generated expressions, each entered as line 10 and so
+ * replacing the one before, which keeps the program at one line and
+ * puts nearly all the time into scanning and parsing.  The
+ * expressions mix every operator, parentheses, unary minus and
+ * assignment, at depths up to four.
+ */
+
+void generateExpression(ostringstream &os, unsigned &seed, int depth) {
+    seed = seed * 1103515245 + 12345;
+    const unsigned r = (seed >> 16) % 8;
+    if (depth == 0 || r < 2) {
+        if (r % 2) os << "v" << seed % 31;
+        else os << seed % 1000;
+        return;
+    }
+    if (r == 2) {
+        os << "(";
+        generateExpression(os, seed, depth - 1);
+        os << ")";
+        return;
+    }
+    if (r == 3 && depth == 4) {
+        os << "-";
+        generateExpression(os, seed, depth - 1);
+        return;
+    }
+    generateExpression(os, seed, depth - 1);
+    os << " " << "+-*/+-*/"[r] << " ";
+    generateExpression(os, seed, depth - 1);
+}
+
+vector<Workload> generateParse() {
+    vector<Workload> workloads;
+    for (int n : {100000, 1000000}) {
+        ostringstream os;
+        unsigned seed = 1;
+        for (int i = 1; i <= n; i++) {
+            os << "10 LET x = ";
+            if (i % 10 == 0) os << "y = ";
+            generateExpression(os, seed, 4);
+            os << "\n";
+        }
+        os << "QUIT\n";
+        workloads.push_back({to_string(n) + " expressions", os.str(), n, ""});
+    }
+    return workloads;
+}
+
+const vector<Scenario> scenarios = {
+        {"run", "RUN throughput against program size", "lines/s", generateRun},
+        {"edit", "re-RUN after single-line edits against program size", "edits/s", generateEdit},
+        {"loop", "executing loop-heavy programs", "lines/s", generateLoop},
+        {"steps", "stepping through a million statement executions", "lines/s", generateSteps},
+        {"straight", "long straight-line loop bodies", "lines/s", generateStraight},
+        {"expr", "evaluating long arithmetic expressions", "lines/s", generateExpr},
+        {"load", "loading a large program without running it", "lines/s", generateLoad},
+        {"scatter", "typing a large program out of order", "lines/s", generateScatter},
+        {"bulkload", "reading a large program from a file with LOAD", "lines/s", generateBulkLoad},
+        {"ifload", "loading a large program of IF statements", "lines/s", generateIfLoad},
+        {"badload", "loading a large program with one bad line in ten", "lines/s", generateBadLoad},
+        {"parse", "parsing a corpus of expressions", "expressions/s", generateParse},
+};
+
+const int repetitions = 3;
+
+double timeInput(const string &exec, const string &flags, const string &input) {
+    ofstream out(inputFile);
+    out << input;
+    out.close();
+    double best = 1e30;
+    for (int i = 0; i < repetitions; i++) { // keep the fastest of a few runs to damp noise
+        auto start = chrono::steady_clock::now();
+        int r = system((exec + " " + flags + " < " + inputFile + " > /dev/null 2> /dev/null").c_str());
+        auto stop = chrono::steady_clock::now();
+        if (r != 0) cout << "  (" << exec << " exited with status " << r << ")" << endl;
+        best = min(best, chrono::duration<double>(stop - start).count());
+    }
+    return best;
+}
+
+double timeRun(const string &exec, const string &flags, const Workload &w) {
+    double t = timeInput(exec, flags, w.input);
+    if (w.setup.size()) t -= timeInput(exec, flags, w.setup);
+    return t > 1e-6 ? t : 1e-6;
+}
+
+string allocReport(const string &exec, const string &flags, const string &input) {
+    const string reportFile = "bench_alloc.txt";
+    ofstream out(inputFile);
+    out << input;
+    out.close();
+    int r = system((exec + " " + flags + " < " + inputFile + " > /dev/null 2> " + reportFile).c_str());
+    (void) r;
+    ifstream in(reportFile);
+    string line, report = "no allocation report";
+    while (getline(in, line)) {
+        if (line.rfind("alloc: ", 0) == 0) report = line.substr(7);
+    }
+    in.close();
+    remove(reportFile.c_str());
+    return report;
+}
+
+void runScenario(const Scenario &s) {
+    cout << "== " << s.name << ": " << s.description << endl;
+    for (const Workload &w : s.generate()) {
+        double t = timeRun(basic, extraFlags, w);
+        cout << "  " << w.label << ": " << t << " s, " << (long long) (w.units / t) << " " << s.unit;
+        if (baseline.size()) {
+            double tb = timeRun(baseline, baselineFlags, w);
+            cout << " | baseline " << tb << " s, " << (long long) (w.units / tb) << " " << s.unit
+                 << ", speedup " << tb / t << "x";
+        }
+        cout << endl;
+        if (allocReports) {
+            cout << "    " << allocReport(basic, extraFlags, w.input);
+            if (baseline.size()) cout << " | baseline " << allocReport(baseline, baselineFlags, w.input);
+            cout << endl;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    parseArguments(argc, argv);
+    for (const Scenario &s : scenarios) {
+        if (scenario.size() && scenario != s.name) continue;
+        runScenario(s);
+    }
+    int r = system(("rm -f " + inputFile + " " + programFile + "_*.bas").c_str());
+    (void) r;
+    return 0;
+}
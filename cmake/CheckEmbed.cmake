@@ -0,0 +1,64 @@
+# CheckEmbed.cmake
+# ----------------
+# Run by the check-embed target.  Every trace in TESTS that loads a
+# program, RUNs it once and then only feeds it INPUT values before QUIT
+# is embedded with BasicProgram (see Basic/embed.hpp) and built with
+# CXX, so that the compiler parses it.  The output of the built program
+# must match what the interpreter BASIC prints for the whole trace.
+# Intermediate files go to WORK.
+
+cmake_minimum_required(VERSION 3.16)
+include("${CMAKE_CURRENT_LIST_DIR}/TraceSample.cmake")
+
+file(MAKE_DIRECTORY "${WORK}")
+file(GLOB traces "${TESTS}/trace*.txt")
+list(SORT traces)
+set(checked 0)
+set(failed "")
+
+foreach (trace IN LISTS traces)
+    get_filename_component(name "${trace}" NAME_WE)
+    basic_trace_sample("${trace}" program input)
+    if (program STREQUAL "")
+        continue()
+    endif ()
+    # 解释器拒绝的行在嵌入时是编译错误，先用 --emit-cpp 筛掉这样的程序
+    execute_process(COMMAND "${BASIC}" --emit-cpp "${trace}"
+                    OUTPUT_QUIET ERROR_VARIABLE warnings RESULT_VARIABLE result)
+    if (NOT result EQUAL 0 OR NOT warnings STREQUAL "")
+        continue()
+    endif ()
+
+    file(WRITE "${WORK}/${name}.cpp"
+         "#include <iostream>\n"
+         "#include \"embed.hpp\"\n"
+         "\n"
+         "static constexpr char source[] = R\"basic(\n${program})basic\";\n"
+         "\n"
+         "int main() {\n"
+         "    BasicProgram<source>::run(std::cin, std::cout);\n"
+         "    return 0;\n"
+         "}\n")
+    execute_process(COMMAND "${CXX}" -std=c++17 -O1 -I "${INCLUDE}" -o "${WORK}/${name}" "${WORK}/${name}.cpp"
+                    RESULT_VARIABLE result ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        list(APPEND failed "${name} (does not compile: ${errors})")
+        continue()
+    endif ()
+    file(WRITE "${WORK}/${name}.in" "${input}")
+    execute_process(COMMAND "${WORK}/${name}" INPUT_FILE "${WORK}/${name}.in"
+                    OUTPUT_VARIABLE actual TIMEOUT 10)
+    execute_process(COMMAND "${BASIC}" INPUT_FILE "${trace}" OUTPUT_VARIABLE expected TIMEOUT 10)
+    math(EXPR checked "${checked} + 1")
+    if (NOT actual STREQUAL expected)
+        file(WRITE "${WORK}/${name}.expected" "${expected}")
+        file(WRITE "${WORK}/${name}.actual" "${actual}")
+        list(APPEND failed "${name}")
+    endif ()
+endforeach ()
+
+message(STATUS "check-embed: ${checked} traces compared")
+if (failed)
+    list(JOIN failed "\n  " report)
+    message(FATAL_ERROR "output differs from the interpreter for:\n  ${report}")
+endif ()
@@ -0,0 +1,40 @@
+# CheckTraces.cmake
+# -----------------
+# Run by the check-traces target.  Every trace in TESTS that has a
+# trace*.expected file next to it is fed to the interpreter BASIC once
+# for each back end in FLAGS, and the output must match the expected
+# file.  These are the traces the reference binary cannot run, so
+# score does not cover them.  Outputs that differ go to WORK.
+
+cmake_minimum_required(VERSION 3.16)
+
+file(MAKE_DIRECTORY "${WORK}")
+file(GLOB traces "${TESTS}/trace*.txt")
+list(SORT traces)
+set(checked 0)
+set(failed "")
+
+foreach (trace IN LISTS traces)
+    get_filename_component(name "${trace}" NAME_WE)
+    if (NOT EXISTS "${TESTS}/${name}.expected")
+        continue()
+    endif ()
+    file(READ "${TESTS}/${name}.expected" expected)
+    math(EXPR checked "${checked} + 1")
+    foreach (flag IN ITEMS "" ${FLAGS})
+        # 每个后端都要和期望输出一致
+        execute_process(COMMAND "${BASIC}" ${flag} INPUT_FILE "${trace}"
+                        OUTPUT_VARIABLE actual ERROR_QUIET TIMEOUT 10)
+        if (NOT actual STREQUAL expected)
+            string(REPLACE "-" "" suffix "${flag}")
+            file(WRITE "${WORK}/${name}${suffix}.actual" "${actual}")
+            list(APPEND failed "${name} ${flag}")
+        endif ()
+    endforeach ()
+endforeach ()
+
+message(STATUS "check-traces: ${checked} traces compared")
+if (failed)
+    list(JOIN failed "\n  " report)
+    message(FATAL_ERROR "output differs from the expected output for:\n  ${report}")
+endif ()
@@ -0,0 +1,43 @@
+# TraceSample.cmake
+# -----------------
+# Shared by the scripts that check a back end against the interpreter.
+# basic_trace_sample(trace program input) sets program to the numbered
+# lines of a trace that loads a program, RUNs it once and then only
+# feeds it INPUT values before QUIT, and input to those values.  For
+# any other trace both are left empty.
+
+function(basic_trace_sample trace program_var input_var)
+    file(STRINGS "${trace}" lines)
+    # 只挑一次 RUN：之前全是带行号的行，之后只有 INPUT 的数值，以 QUIT 结尾
+    set(state "program")
+    set(eligible TRUE)
+    set(last "")
+    set(program "")
+    set(input "")
+    foreach (line IN LISTS lines)
+        string(STRIP "${line}" line)
+        if (line STREQUAL "")
+            continue()
+        endif ()
+        set(last "${line}")
+        if (state STREQUAL "program")
+            if (line STREQUAL "RUN")
+                set(state "input")
+            elseif (line MATCHES "^[0-9]")
+                string(APPEND program "${line}\n")
+            else ()
+                set(eligible FALSE)
+            endif ()
+        elseif (line MATCHES "^-?[0-9]+$")
+            string(APPEND input "${line}\n")
+        elseif (NOT line STREQUAL "QUIT")
+            set(eligible FALSE)
+        endif ()
+    endforeach ()
+    if (NOT eligible OR NOT state STREQUAL "input" OR NOT last STREQUAL "QUIT")
+        set(program "")
+        set(input "")
+    endif ()
+    set(${program_var} "${program}" PARENT_SCOPE)
+    set(${input_var} "${input}" PARENT_SCOPE)
+endfunction()